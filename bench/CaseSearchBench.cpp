@@ -0,0 +1,149 @@
+// bench/CaseSearchBench.cpp
+// Микробенчмарк поиска слов в теле ответа:
+//   baseline  — прежний путь Worker (std::transform(::tolower) копии + std::string::find),
+//   scalar/sse2/avx2 — ядро CaseSearch с явным выбором реализации,
+//   matcher   — KeywordMatcher (прямой поиск и автомат) при подаче тела кусками по 16 КБ.
+//
+// Использование: CaseSearchBench [--words=w1,w2] [file.html ...]
+// Если файлы не заданы, используется синтетический HTML.
+#include "CaseSearch.hpp"
+#include "KeywordMatcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+std::string syntheticHtml() {
+    std::string html = "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>Example Site</title>"
+                       "<link rel=\"stylesheet\" href=\"/static/css/main.css\"></head><body>";
+    for (int i = 0; i < 200; ++i) {
+        html += "<div class=\"item item-" + std::to_string(i) + "\"><a href=\"/catalog/section/" +
+                std::to_string(i) + "/\">Product Name " + std::to_string(i) +
+                "</a><p>Lorem ipsum dolor sit amet, consectetur adipiscing elit.</p></div>\n";
+    }
+    html += "</body></html>";
+    return html;
+}
+
+// Повторяет корпус до нужного размера
+std::string makeBuffer(const std::string& corpus, size_t size) {
+    std::string buf;
+    buf.reserve(size);
+    while (buf.size() < size)
+        buf.append(corpus, 0, std::min(corpus.size(), size - buf.size()));
+    return buf;
+}
+
+std::vector<std::string> splitWords(const std::string& value) {
+    std::vector<std::string> out;
+    std::stringstream ss(value);
+    std::string w;
+    while (std::getline(ss, w, ','))
+        if (!w.empty())
+            out.push_back(w);
+    return out;
+}
+
+template <typename F>
+double measure(size_t bytes, F&& fn) {
+    // Не меньше ~64 МБ суммарно и не меньше 5 повторов
+    size_t iters = std::max<size_t>(5, (64u << 20) / std::max<size_t>(bytes, 1));
+    volatile size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iters; ++i)
+        sink = sink + fn();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(bytes) * static_cast<double>(iters) / sec / (1024.0 * 1024.0);
+}
+
+size_t baseline(const std::string& body, const std::vector<std::string>& words) {
+    std::string body_lower = body;
+    std::transform(body_lower.begin(), body_lower.end(), body_lower.begin(), ::tolower);
+    for (const auto& word : words) {
+        std::string word_lower = word;
+        std::transform(word_lower.begin(), word_lower.end(), word_lower.begin(), ::tolower);
+        if (body_lower.find(word_lower) == std::string::npos)
+            return 0;
+    }
+    return 1;
+}
+
+size_t kernel(CaseSearch::Impl impl, const std::string& body, const std::vector<std::string>& lowerWords) {
+    for (const auto& w : lowerWords) {
+        if (CaseSearch::find(impl, body.data(), body.size(), w.data(), w.size()) == CaseSearch::npos)
+            return 0;
+    }
+    return 1;
+}
+
+size_t streamed(const KeywordMatcher& m, const std::string& body) {
+    const size_t chunk = 16 * 1024;
+    KeywordMatcher::State st;
+    m.reset(st);
+    for (size_t off = 0; off < body.size(); off += chunk) {
+        if (m.feed(st, body.data() + off, std::min(chunk, body.size() - off)))
+            break;
+    }
+    return m.matched(st) ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // По умолчанию ищем слова, которых нет в корпусе, — худший случай (полный проход)
+    std::vector<std::string> words = {"bitrix", "aspro"};
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--words=", 0) == 0)
+            words = splitWords(arg.substr(8));
+        else
+            files.push_back(arg);
+    }
+
+    std::string corpus;
+    for (const auto& f : files)
+        corpus += readFile(f);
+    if (corpus.empty())
+        corpus = syntheticHtml();
+
+    KeywordMatcher direct(words);
+    direct.setDirect(true);
+    KeywordMatcher automaton(words);
+    automaton.setDirect(false);
+    const std::vector<std::string>& lowerWords = direct.words();
+
+    std::printf("CPU best: %s, words:", CaseSearch::name(CaseSearch::best()));
+    for (const auto& w : words)
+        std::printf(" %s", w.c_str());
+    std::printf("\n%-8s %10s %10s %10s %10s %10s %10s  (MB/s)\n",
+                "size", "baseline", "scalar", "sse2", "avx2", "m-direct", "m-ac");
+
+    const size_t sizes[] = {1u << 10, 4u << 10, 16u << 10, 64u << 10, 256u << 10, 1u << 20, 5u << 20};
+    for (size_t size : sizes) {
+        std::string body = makeBuffer(corpus, size);
+        std::printf("%-8zu %10.0f", size, measure(size, [&] { return baseline(body, words); }));
+        for (auto impl : {CaseSearch::Impl::Scalar, CaseSearch::Impl::Sse2, CaseSearch::Impl::Avx2}) {
+            if (CaseSearch::supported(impl))
+                std::printf(" %10.0f", measure(size, [&] { return kernel(impl, body, lowerWords); }));
+            else
+                std::printf(" %10s", "n/a");
+        }
+        std::printf(" %10.0f", measure(size, [&] { return streamed(direct, body); }));
+        std::printf(" %10.0f\n", measure(size, [&] { return streamed(automaton, body); }));
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+// bench/CrawlBench.cpp
+// Сквозной бенчмарк: краулер (библиотека CrawlerCore, отдельный процесс) против
+// локального SyntheticServer. Сеть не нужна, ответы воспроизводимы, поэтому
+// результаты разных сборок можно сравнивать между собой.
+//
+// Использование:
+//   CrawlBench [--hosts=N] [--threads=N] [--concurrency=N] [--server-threads=N]
+//              [--size=MIN[-MAX]] [--latency-ms=MEAN] [--trickle=SHARE[:MS]] [--reset=SHARE]
+//              [--redirects=SHARE[:HOPS]] [--match=SHARE] [--gzip] [--tls] [--keep]
+//              [-- опции краулера ...]
+//
+// Отчёт: пропускная способность, p50/p99 времени ответа и первого байта (по CSV
+// краулера), процессорное время на запрос и пиковый RSS процесса краулера.
+#include "Crawler.hpp"
+#include "SyntheticServer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct Options {
+    SyntheticServer::Config server;
+    size_t hosts = 10000;
+    int threads = 1;
+    int concurrency = 200;
+    bool keep = false;
+    std::vector<std::string> crawlerArgs;
+};
+
+bool parseShare(const std::string& v, double& share, uint32_t* second) {
+    share = std::atof(v.c_str());
+    size_t colon = v.find(':');
+    if (second && colon != std::string::npos)
+        *second = static_cast<uint32_t>(std::atol(v.c_str() + colon + 1));
+    return share >= 0 && share <= 1;
+}
+
+bool parseOptions(int argc, char* argv[], Options& o) {
+    SyntheticServer::Config& s = o.server;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const char* prefix) { return arg.substr(std::strlen(prefix)); };
+        if (arg == "--") {
+            o.crawlerArgs.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg.rfind("--hosts=", 0) == 0) {
+            o.hosts = static_cast<size_t>(std::atoll(value("--hosts=").c_str()));
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            o.threads = std::atoi(value("--threads=").c_str());
+        } else if (arg.rfind("--concurrency=", 0) == 0) {
+            o.concurrency = std::atoi(value("--concurrency=").c_str());
+        } else if (arg.rfind("--server-threads=", 0) == 0) {
+            s.threads = std::atoi(value("--server-threads=").c_str());
+        } else if (arg.rfind("--size=", 0) == 0) {
+            std::string v = value("--size=");
+            s.minSize = static_cast<size_t>(std::atoll(v.c_str()));
+            size_t dash = v.find('-');
+            s.maxSize = dash == std::string::npos ? s.minSize : static_cast<size_t>(std::atoll(v.c_str() + dash + 1));
+        } else if (arg.rfind("--latency-ms=", 0) == 0) {
+            s.latencyMs = std::atof(value("--latency-ms=").c_str());
+        } else if (arg.rfind("--trickle=", 0) == 0) {
+            if (!parseShare(value("--trickle="), s.trickleShare, &s.trickleMs))
+                return false;
+        } else if (arg.rfind("--reset=", 0) == 0) {
+            if (!parseShare(value("--reset="), s.resetShare, nullptr))
+                return false;
+        } else if (arg.rfind("--redirects=", 0) == 0) {
+            uint32_t hops = static_cast<uint32_t>(s.redirectHops);
+            if (!parseShare(value("--redirects="), s.redirectShare, &hops))
+                return false;
+            s.redirectHops = static_cast<int>(hops);
+        } else if (arg.rfind("--match=", 0) == 0) {
+            if (!parseShare(value("--match="), s.matchShare, nullptr))
+                return false;
+        } else if (arg == "--gzip") {
+            s.gzip = true;
+        } else if (arg == "--tls") {
+            s.tls = true;
+        } else if (arg == "--keep") {
+            o.keep = true;
+        } else {
+            std::fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return o.hosts > 0 && o.threads > 0 && o.concurrency > 0 && s.threads > 0 && s.maxSize > 0;
+}
+
+// Значение квантиля отсортированной выборки
+uint64_t quantile(const std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty())
+        return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5))];
+}
+
+struct Results {
+    size_t records = 0, ok = 0, matched = 0;
+    std::vector<uint64_t> total, ttfb;
+};
+
+// CSV краулера: domain,http_code,curl_code,effective_url,bytes,dns_us,connect_us,tls_us,ttfb_us,total_us,retries,evicted,truncated,matched,...
+Results readResults(const std::string& path) {
+    Results r;
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line); // заголовок
+    std::vector<std::string> fields;
+    while (std::getline(in, line)) {
+        fields.clear();
+        std::stringstream ss(line);
+        std::string f;
+        while (std::getline(ss, f, ','))
+            fields.push_back(f);
+        if (fields.size() < 14)
+            continue;
+        ++r.records;
+        if (fields[2] == "0") {
+            ++r.ok;
+            r.ttfb.push_back(std::strtoull(fields[8].c_str(), nullptr, 10));
+            r.total.push_back(std::strtoull(fields[9].c_str(), nullptr, 10));
+        }
+        if (fields[13] == "1")
+            ++r.matched;
+    }
+    std::sort(r.total.begin(), r.total.end());
+    std::sort(r.ttfb.begin(), r.ttfb.end());
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options o;
+    if (!parseOptions(argc, argv, o)) {
+        std::fprintf(stderr,
+                     "Usage: %s [--hosts=N] [--threads=N] [--concurrency=N] [--server-threads=N] [--size=MIN[-MAX]]"
+                     " [--latency-ms=MEAN] [--trickle=SHARE[:MS]] [--reset=SHARE] [--redirects=SHARE[:HOPS]]"
+                     " [--match=SHARE] [--gzip] [--tls] [--keep] [-- crawler options...]\n", argv[0]);
+        return 1;
+    }
+
+    SyntheticServer server(o.server);
+    std::string error;
+    if (!server.listen(error)) {
+        std::fprintf(stderr, "Server: %s\n", error.c_str());
+        return 1;
+    }
+
+    // Домены hN.localhost: libcurl разрешает *.localhost в 127.0.0.1 без DNS
+    char dirTemplate[] = "/tmp/crawlbench.XXXXXX";
+    const char* dir = mkdtemp(dirTemplate);
+    if (!dir) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    std::string domainsPath = std::string(dir) + "/domains.txt";
+    std::string outputPath = std::string(dir) + "/results.csv";
+    {
+        std::ofstream domains(domainsPath);
+        const char* scheme = o.server.tls ? "https://" : "";
+        for (size_t i = 0; i < o.hosts; ++i)
+            domains << scheme << 'h' << i << ".localhost:" << server.port() << '\n';
+    }
+
+    std::vector<std::string> args = {"HighPerfCrawler", domainsPath, outputPath, std::to_string(o.threads),
+                                     "--contains=bitrix", "--format=csv",
+                                     "--concurrency=" + std::to_string(o.concurrency)};
+    args.insert(args.end(), o.crawlerArgs.begin(), o.crawlerArgs.end());
+
+    std::printf("server: port %u, %d thread(s), body %zu-%zu B, latency %.1f ms, trickle %.2f, reset %.2f, "
+                "redirects %.2fx%d, match %.2f%s%s\n",
+                server.port(), o.server.threads, o.server.minSize, o.server.maxSize, o.server.latencyMs,
+                o.server.trickleShare, o.server.resetShare, o.server.redirectShare, o.server.redirectHops,
+                o.server.matchShare, o.server.gzip ? ", gzip" : "", o.server.tls ? ", tls" : "");
+    std::printf("crawler:");
+    for (const auto& a : args)
+        std::printf(" %s", a.c_str());
+    std::printf("\n");
+    std::fflush(stdout);
+
+    // Краулер — в дочернем процессе, чтобы его CPU и пиковый RSS не смешивались с сервером.
+    // fork до запуска потоков сервера: слушающие сокеты уже принимают соединения.
+    auto started = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        server.closeListeners();
+        std::vector<char*> cargv;
+        for (auto& a : args)
+            cargv.push_back(&a[0]);
+        cargv.push_back(nullptr);
+        std::exit(Crawler::run(static_cast<int>(args.size()), cargv.data()));
+    }
+    server.start();
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    server.stop();
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::fprintf(stderr, "Crawler failed (status %d), files kept in %s\n", status, dir);
+        return 1;
+    }
+
+    Results r = readResults(outputPath);
+    SyntheticServer::Stats st = server.stats();
+    double cpu = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                 static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    double rssMb = static_cast<double>(usage.ru_maxrss) / 1024.0;
+    size_t slots = static_cast<size_t>(o.threads) * static_cast<size_t>(o.concurrency);
+
+    std::printf("results:    %zu records, %zu ok, %zu matched (server: %llu requests, %llu redirects, %llu resets, %.1f MB)\n",
+                r.records, r.ok, r.matched, static_cast<unsigned long long>(st.requests),
+                static_cast<unsigned long long>(st.redirects), static_cast<unsigned long long>(st.resets),
+                static_cast<double>(st.bytesSent) / (1024.0 * 1024.0));
+    std::printf("throughput: %.0f domains/s (%.2f s wall)\n", static_cast<double>(r.records) / wall, wall);
+    std::printf("total:      p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", quantile(r.total, 0.5) / 1e3,
+                quantile(r.total, 0.99) / 1e3, quantile(r.total, 1.0) / 1e3);
+    std::printf("first byte: p50 %.2f ms, p99 %.2f ms\n", quantile(r.ttfb, 0.5) / 1e3, quantile(r.ttfb, 0.99) / 1e3);
+    std::printf("cpu:        %.2f s (user+sys), %.1f us/domain\n", cpu,
+                r.records ? cpu * 1e6 / static_cast<double>(r.records) : 0.0);
+    std::printf("memory:     peak RSS %.1f MB, %.1f KB per transfer slot (%zu slots)\n", rssMb,
+                rssMb * 1024.0 / static_cast<double>(slots), slots);
+
+    if (!o.keep) {
+        std::remove(domainsPath.c_str());
+        std::remove(outputPath.c_str());
+        rmdir(dir);
+    } else {
+        std::printf("files:      %s\n", dir);
+    }
+    return 0;
+}
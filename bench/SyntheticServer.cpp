@@ -0,0 +1,547 @@
+// bench/SyntheticServer.cpp
+#include "SyntheticServer.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <queue>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#ifdef BENCH_WITH_TLS
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+#ifdef BENCH_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr unsigned kSizeSteps = 64;
+const char* const kMarker = "<meta name=\"generator\" content=\"1C-Bitrix\">";
+
+uint64_t nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t fnv1a(std::string_view s, uint64_t h = 1469598103934665603ull) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Равномерное число [0, 1) из хэша хоста и номера признака
+double uniform(uint64_t h, uint64_t k) {
+    uint64_t z = h + k * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Значение заголовка (без учёта регистра имени) или пустая строка
+std::string_view headerValue(std::string_view head, std::string_view name) {
+    size_t pos = head.find("\r\n");
+    while (pos != std::string_view::npos && pos + 2 < head.size()) {
+        size_t start = pos + 2;
+        size_t end = head.find("\r\n", start);
+        std::string_view line = head.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+        if (line.size() > name.size() && line[name.size()] == ':' &&
+            std::equal(name.begin(), name.end(), line.begin(),
+                       [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) ==
+                                                   std::tolower(static_cast<unsigned char>(b)); })) {
+            std::string_view v = line.substr(name.size() + 1);
+            while (!v.empty() && v.front() == ' ')
+                v.remove_prefix(1);
+            return v;
+        }
+        pos = end;
+    }
+    return std::string_view();
+}
+
+#ifdef BENCH_WITH_TLS
+// Самоподписанный сертификат на EC P-256; краулер проверку сертификатов не выполняет
+SSL_CTX* makeTlsContext(std::string& error) {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    if (!ctx || !kctx || EVP_PKEY_keygen_init(kctx) <= 0 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) <= 0 ||
+        EVP_PKEY_keygen(kctx, &key) <= 0) {
+        error = "TLS key generation failed";
+        EVP_PKEY_CTX_free(kctx);
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+    EVP_PKEY_CTX_free(kctx);
+    X509* cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 7 * 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    bool ok = X509_sign(cert, key, EVP_sha256()) > 0 && SSL_CTX_use_certificate(ctx, cert) == 1 &&
+              SSL_CTX_use_PrivateKey(ctx, key) == 1;
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    if (!ok) {
+        error = "TLS certificate setup failed";
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    return ctx;
+}
+#endif
+
+#ifdef BENCH_WITH_ZLIB
+std::string gzipCompress(const std::string& data) {
+    z_stream zs{};
+    deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, data.size()) + 32, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+#endif
+
+} // namespace
+
+// Цикл одного потока: соединения, таймеры задержек и медленной отдачи, кэш тел
+struct SyntheticServer::Loop {
+    struct Conn {
+        int         fd = -1;
+        uint64_t    gen = 0;
+        void*       ssl = nullptr;
+        bool        handshake = false;
+        enum Phase { Reading, Delayed, Writing, Trickling } phase = Reading;
+        std::string in;
+        std::string out;
+        size_t      outPos = 0;
+        size_t      sendLimit = SIZE_MAX; // медленная отдача: сколько байт out можно отправить сейчас
+        bool        keepAlive = true;
+    };
+    struct Timer {
+        uint64_t due;
+        int      fd;
+        uint64_t gen;
+        bool operator>(const Timer& o) const { return due > o.due; }
+    };
+
+    const Config&                     config;
+    const std::atomic<bool>&          stopping;
+    int                               listenFd;
+    void*                             sslCtx;
+    int                               epfd = -1;
+    uint64_t                          nextGen = 1;
+    std::vector<std::unique_ptr<Conn>> conns; // по номеру дескриптора
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::unordered_map<unsigned, std::string> bodies; // (ступень размера, совпадение, gzip) -> тело
+    std::string                       filler;
+    Stats                             stats;
+
+    Loop(const Config& c, const std::atomic<bool>& stop, int fd, void* ctx)
+        : config(c), stopping(stop), listenFd(fd), sslCtx(ctx) {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = listenFd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+        // Наполнитель тела: правдоподобная разметка без ключевых слов
+        const std::string row = "<div class=\"item\"><a href=\"/catalog/item/\">Product name</a>"
+                                "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit.</p></div>\n";
+        while (filler.size() < config.maxSize)
+            filler += row;
+        filler.resize(config.maxSize);
+    }
+
+    ~Loop() {
+        for (auto& c : conns) {
+            if (c)
+                closeConn(*c, false);
+        }
+        if (epfd >= 0)
+            close(epfd);
+    }
+
+    size_t sizeOf(unsigned step) const {
+        return config.minSize + (config.maxSize - config.minSize) * step / (kSizeSteps - 1);
+    }
+
+    const std::string& body(unsigned step, bool match, bool gzip) {
+        unsigned key = step * 4 + (match ? 2 : 0) + (gzip ? 1 : 0);
+        auto it = bodies.find(key);
+        if (it != bodies.end())
+            return it->second;
+        std::string b = filler.substr(0, sizeOf(step));
+        size_t markerLen = std::strlen(kMarker);
+        if (match && b.size() >= markerLen)
+            b.replace(b.size() * 3 / 4 - std::min(b.size() * 3 / 4, markerLen), markerLen, kMarker);
+#ifdef BENCH_WITH_ZLIB
+        if (gzip)
+            b = gzipCompress(b);
+#endif
+        return bodies.emplace(key, std::move(b)).first->second;
+    }
+
+    void run() {
+        std::vector<epoll_event> events(256);
+        while (!stopping.load(std::memory_order_relaxed)) {
+            int timeout = 100;
+            if (!timers.empty()) {
+                uint64_t now = nowMs();
+                timeout = timers.top().due <= now ? 0 : static_cast<int>(std::min<uint64_t>(100, timers.top().due - now));
+            }
+            int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), timeout);
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                } else if (static_cast<size_t>(fd) < conns.size() && conns[fd]) {
+                    advance(*conns[fd]);
+                }
+            }
+            uint64_t now = nowMs();
+            while (!timers.empty() && timers.top().due <= now) {
+                Timer t = timers.top();
+                timers.pop();
+                if (static_cast<size_t>(t.fd) >= conns.size() || !conns[t.fd] || conns[t.fd]->gen != t.gen)
+                    continue; // соединение уже закрыто
+                Conn& c = *conns[t.fd];
+                if (c.phase == Conn::Trickling)
+                    c.sendLimit = std::min(c.out.size(), c.sendLimit + config.trickleChunk);
+                c.phase = Conn::Writing;
+                advance(c);
+            }
+        }
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (static_cast<size_t>(fd) >= conns.size())
+                conns.resize(static_cast<size_t>(fd) + 1);
+            auto c = std::make_unique<Conn>();
+            c->fd = fd;
+            c->gen = nextGen++;
+#ifdef BENCH_WITH_TLS
+            if (sslCtx) {
+                SSL* ssl = SSL_new(static_cast<SSL_CTX*>(sslCtx));
+                SSL_set_fd(ssl, fd);
+                c->ssl = ssl;
+                c->handshake = true;
+            }
+#endif
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.fd = fd;
+            epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+            conns[fd] = std::move(c);
+            advance(*conns[fd]);
+        }
+    }
+
+    // >0 — прочитано, 0 — соединение закрыто, -1 — данных пока нет, -2 — ошибка
+    ssize_t readSome(Conn& c, char* buf, size_t len) {
+#ifdef BENCH_WITH_TLS
+        if (c.ssl) {
+            int n = SSL_read(static_cast<SSL*>(c.ssl), buf, static_cast<int>(len));
+            if (n > 0)
+                return n;
+            int err = SSL_get_error(static_cast<SSL*>(c.ssl), n);
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+                return -1;
+            ERR_clear_error();
+            return err == SSL_ERROR_ZERO_RETURN ? 0 : -2;
+        }
+#endif
+        ssize_t n = recv(c.fd, buf, len, 0);
+        if (n >= 0)
+            return n;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? -1 : -2;
+    }
+
+    ssize_t writeSome(Conn& c, const char* buf, size_t len) {
+#ifdef BENCH_WITH_TLS
+        if (c.ssl) {
+            int n = SSL_write(static_cast<SSL*>(c.ssl), buf, static_cast<int>(std::min<size_t>(len, 1 << 20)));
+            if (n > 0)
+                return n;
+            int err = SSL_get_error(static_cast<SSL*>(c.ssl), n);
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+                return -1;
+            ERR_clear_error();
+            return -2;
+        }
+#endif
+        ssize_t n = send(c.fd, buf, len, MSG_NOSIGNAL);
+        if (n >= 0)
+            return n;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? -1 : -2;
+    }
+
+    void closeConn(Conn& c, bool reset) {
+        int fd = c.fd;
+        if (reset) {
+            linger lg{1, 0};
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        }
+#ifdef BENCH_WITH_TLS
+        if (c.ssl) {
+            if (!reset && !c.handshake)
+                SSL_shutdown(static_cast<SSL*>(c.ssl));
+            SSL_free(static_cast<SSL*>(c.ssl));
+        }
+#endif
+        close(fd);
+        conns[fd].reset();
+    }
+
+    // Продвигает соединение, пока оно не упрётся в сокет или таймер
+    void advance(Conn& c) {
+#ifdef BENCH_WITH_TLS
+        if (c.handshake) {
+            int r = SSL_accept(static_cast<SSL*>(c.ssl));
+            if (r != 1) {
+                int err = SSL_get_error(static_cast<SSL*>(c.ssl), r);
+                if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+                    ERR_clear_error();
+                    closeConn(c, false);
+                }
+                return;
+            }
+            c.handshake = false;
+        }
+#endif
+        char buf[16384];
+        while (true) {
+            if (c.phase == Conn::Reading) {
+                size_t end = c.in.find("\r\n\r\n");
+                if (end == std::string::npos) {
+                    ssize_t n = readSome(c, buf, sizeof(buf));
+                    if (n == -1)
+                        return;
+                    if (n <= 0 || c.in.size() > 65536) {
+                        closeConn(c, false);
+                        return;
+                    }
+                    c.in.append(buf, static_cast<size_t>(n));
+                    continue;
+                }
+                if (!respond(c, std::string_view(c.in).substr(0, end + 4)))
+                    return; // соединение сброшено
+                c.in.erase(0, end + 4);
+                continue;
+            }
+            if (c.phase != Conn::Writing)
+                return;
+            size_t limit = std::min(c.out.size(), c.sendLimit);
+            while (c.outPos < limit) {
+                ssize_t n = writeSome(c, c.out.data() + c.outPos, limit - c.outPos);
+                if (n == -1)
+                    return;
+                if (n < 0) {
+                    closeConn(c, false);
+                    return;
+                }
+                c.outPos += static_cast<size_t>(n);
+                stats.bytesSent += static_cast<uint64_t>(n);
+            }
+            if (c.outPos < c.out.size()) {
+                c.phase = Conn::Trickling;
+                timers.push({nowMs() + config.trickleMs, c.fd, c.gen});
+                return;
+            }
+            if (!c.keepAlive) {
+                closeConn(c, false);
+                return;
+            }
+            c.out.clear();
+            c.outPos = 0;
+            c.sendLimit = SIZE_MAX;
+            c.phase = Conn::Reading;
+        }
+    }
+
+    // Формирует ответ на запрос head; false — соединение сброшено
+    bool respond(Conn& c, std::string_view head) {
+        ++stats.requests;
+        size_t sp1 = head.find(' ');
+        size_t sp2 = sp1 == std::string_view::npos ? sp1 : head.find(' ', sp1 + 1);
+        std::string_view path = sp2 == std::string_view::npos ? "/" : head.substr(sp1 + 1, sp2 - sp1 - 1);
+        std::string_view host = headerValue(head, "Host");
+        host = host.substr(0, host.find(':'));
+        std::string_view connection = headerValue(head, "Connection");
+        c.keepAlive = !(connection.size() == 5 && std::tolower(static_cast<unsigned char>(connection[0])) == 'c');
+
+        uint64_t h = fnv1a(host);
+        int hop = 0;
+        if (path.rfind("/hop/", 0) == 0)
+            hop = std::atoi(std::string(path.substr(5)).c_str());
+        if (hop == 0 && uniform(h, 1) < config.resetShare) {
+            ++stats.resets;
+            closeConn(c, true);
+            return false;
+        }
+
+        c.out.clear();
+        c.outPos = 0;
+        c.sendLimit = SIZE_MAX;
+        int hops = uniform(h, 2) < config.redirectShare ? config.redirectHops : 0;
+        if (hop < hops) {
+            ++stats.redirects;
+            c.out = "HTTP/1.1 302 Found\r\nLocation: /hop/" + std::to_string(hop + 1) +
+                    "\r\nContent-Length: 0\r\n";
+            c.out += c.keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        } else {
+            unsigned step = std::min(kSizeSteps - 1, static_cast<unsigned>(uniform(h, 3) * kSizeSteps));
+            bool match = uniform(h, 4) < config.matchShare;
+            bool gzip = false;
+#ifdef BENCH_WITH_ZLIB
+            gzip = config.gzip && headerValue(head, "Accept-Encoding").find("gzip") != std::string_view::npos;
+#endif
+            const std::string& b = body(step, match, gzip);
+            c.out = "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: " +
+                    std::to_string(b.size()) + "\r\n";
+            if (gzip)
+                c.out += "Content-Encoding: gzip\r\n";
+            c.out += c.keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+            c.out += b;
+            if (uniform(h, 5) < config.trickleShare)
+                c.sendLimit = std::min(c.out.size(), config.trickleChunk);
+        }
+
+        // Задержка ответа: экспоненциальная со средним latencyMs (хвост обрезан на 10 средних)
+        double delay = 0;
+        if (config.latencyMs > 0) {
+            double u = uniform(fnv1a(path, h), 6);
+            delay = std::min(-config.latencyMs * std::log(1.0 - u), config.latencyMs * 10);
+        }
+        if (delay >= 1) {
+            c.phase = Conn::Delayed;
+            timers.push({nowMs() + static_cast<uint64_t>(delay), c.fd, c.gen});
+        } else {
+            c.phase = Conn::Writing;
+        }
+        return true;
+    }
+};
+
+SyntheticServer::SyntheticServer(const Config& c) : config(c) {
+    config.threads = std::max(1, config.threads);
+    config.maxSize = std::max(config.maxSize, config.minSize);
+}
+
+SyntheticServer::~SyntheticServer() {
+    stop();
+    closeListeners();
+#ifdef BENCH_WITH_TLS
+    SSL_CTX_free(static_cast<SSL_CTX*>(sslCtx));
+#endif
+}
+
+bool SyntheticServer::listen(std::string& error) {
+    if (config.tls) {
+#ifdef BENCH_WITH_TLS
+        sslCtx = makeTlsContext(error);
+        if (!sslCtx)
+            return false;
+#else
+        error = "built without OpenSSL, TLS is not available";
+        return false;
+#endif
+    }
+#ifndef BENCH_WITH_ZLIB
+    if (config.gzip) {
+        error = "built without zlib, gzip is not available";
+        return false;
+    }
+#endif
+    uint16_t port = config.port;
+    for (int i = 0; i < config.threads; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sa.sin_port = htons(port);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 || ::listen(fd, 4096) != 0) {
+            error = std::string("bind/listen failed: ") + std::strerror(errno);
+            close(fd);
+            return false;
+        }
+        if (port == 0) {
+            socklen_t len = sizeof(sa);
+            getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+            port = ntohs(sa.sin_port);
+        }
+        listenFds.push_back(fd);
+    }
+    boundPort = port;
+    return true;
+}
+
+void SyntheticServer::closeListeners() {
+    for (int fd : listenFds)
+        close(fd);
+    listenFds.clear();
+}
+
+void SyntheticServer::start() {
+    stopping = false;
+    for (int fd : listenFds) {
+        loops.push_back(std::make_unique<Loop>(config, stopping, fd, sslCtx));
+        Loop* loop = loops.back().get();
+        threads.emplace_back([loop] { loop->run(); });
+    }
+}
+
+void SyntheticServer::stop() {
+    stopping = true;
+    for (auto& t : threads) {
+        if (t.joinable())
+            t.join();
+    }
+    threads.clear();
+}
+
+SyntheticServer::Stats SyntheticServer::stats() const {
+    Stats total;
+    for (const auto& loop : loops) {
+        total.requests  += loop->stats.requests;
+        total.redirects += loop->stats.redirects;
+        total.resets    += loop->stats.resets;
+        total.bytesSent += loop->stats.bytesSent;
+    }
+    return total;
+}
@@ -0,0 +1,70 @@
+// bench/SyntheticServer.hpp
+#ifndef SYNTHETICSERVER_HPP
+#define SYNTHETICSERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Локальный HTTP(S)-сервер для сквозного бенчмарка. Каждый поток — свой epoll и
+// свой слушающий сокет (SO_REUSEPORT) на общем порту. Виртуальные хосты не
+// настраиваются: поведение выбирается хэшем заголовка Host (hN.localhost), поэтому
+// тысячи хостов стоят столько же, сколько один, а повторный прогон с той же
+// конфигурацией получает те же ответы.
+class SyntheticServer {
+public:
+    struct Config {
+        uint16_t port = 0;            // 0 — выбрать свободный
+        int      threads = 1;
+        size_t   minSize = 4096;      // размер тела (равномерно по 64 ступеням)
+        size_t   maxSize = 65536;
+        double   latencyMs = 5;       // средняя задержка ответа (экспоненциальное распределение)
+        double   trickleShare = 0;    // доля хостов, отдающих тело медленно
+        uint32_t trickleMs = 100;     //   пауза между кусками
+        size_t   trickleChunk = 1024; //   размер куска
+        double   resetShare = 0;      // доля хостов, рвущих соединение (RST) вместо ответа
+        double   redirectShare = 0;   // доля хостов с цепочкой редиректов
+        int      redirectHops = 2;
+        double   matchShare = 0.3;    // доля хостов, тело которых содержит "bitrix"
+        bool     gzip = false;        // сжимать тело, если клиент принимает gzip
+        bool     tls = false;         // только HTTPS (самоподписанный сертификат)
+    };
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t redirects = 0;
+        uint64_t resets = 0;
+        uint64_t bytesSent = 0;
+    };
+
+    explicit SyntheticServer(const Config& config);
+    ~SyntheticServer();
+
+    // Создаёт слушающие сокеты (до fork процесса краулера); после этого известен port()
+    bool listen(std::string& error);
+    uint16_t port() const { return boundPort; }
+    // Для дочернего процесса: закрыть унаследованные сокеты
+    void closeListeners();
+
+    void start();
+    void stop();
+    // Сумма по потокам; вызывается после stop()
+    Stats stats() const;
+
+private:
+    struct Loop;
+
+    Config                             config;
+    uint16_t                           boundPort = 0;
+    std::vector<int>                   listenFds;
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::vector<std::thread>           threads;
+    std::atomic<bool>                  stopping{false};
+    void*                              sslCtx = nullptr; // SSL_CTX при BENCH_WITH_TLS
+};
+
+#endif // SYNTHETICSERVER_HPP
@@ -0,0 +1,94 @@
+// src/BloomFilter.hpp
+#ifndef BLOOMFILTER_HPP
+#define BLOOMFILTER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Масштабируемый фильтр Блума для 64-битных отпечатков (FingerprintSet::fingerprint).
+// Число элементов заранее известно лишь приблизительно, поэтому фильтр состоит из
+// срезов: когда текущий срез набрал свою ёмкость, добавляется новый, вдвое больше и
+// с вдвое меньшей долей ложных срабатываний. Сумма ряда ограничивает общую долю
+// ложных срабатываний значением falsePositiveRate при любом числе элементов.
+// Позиции бит — двойное хэширование по двум половинам отпечатка.
+class BloomFilter {
+public:
+    BloomFilter(size_t expected, double falsePositiveRate)
+        : nextCapacity(expected ? expected : 1), nextRate(falsePositiveRate / 2) {}
+
+    // true — отпечаток добавлен впервые (false — уже был или ложное срабатывание)
+    bool insert(uint64_t fp) {
+        for (const Slice& s : slices) {
+            if (s.contains(fp))
+                return false;
+        }
+        if (slices.empty() || slices.back().count >= slices.back().capacity)
+            addSlice();
+        slices.back().set(fp);
+        ++count;
+        return true;
+    }
+
+    size_t size() const { return count; }
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (const Slice& s : slices)
+            bytes += s.words.size() * sizeof(uint64_t);
+        return bytes;
+    }
+
+private:
+    struct Slice {
+        std::vector<uint64_t> words;
+        uint64_t              bits = 0;
+        unsigned              hashes = 1;
+        size_t                capacity = 0;
+        size_t                count = 0;
+
+        // i-я позиция: (h1 + i*h2) mod bits без деления (умножение на 128 бит)
+        uint64_t position(uint64_t fp, unsigned i) const {
+            uint64_t h2 = (fp >> 32) | (fp << 32) | 1;
+            uint64_t h = fp + i * h2;
+            return static_cast<uint64_t>((static_cast<unsigned __int128>(h) * bits) >> 64);
+        }
+        bool contains(uint64_t fp) const {
+            for (unsigned i = 0; i < hashes; ++i) {
+                uint64_t p = position(fp, i);
+                if (!((words[p >> 6] >> (p & 63)) & 1))
+                    return false;
+            }
+            return true;
+        }
+        void set(uint64_t fp) {
+            for (unsigned i = 0; i < hashes; ++i) {
+                uint64_t p = position(fp, i);
+                words[p >> 6] |= uint64_t(1) << (p & 63);
+            }
+            ++count;
+        }
+    };
+
+    void addSlice() {
+        // m = -n ln p / ln^2 2, k = m/n ln 2
+        const double ln2 = std::log(2.0);
+        Slice s;
+        s.capacity = nextCapacity;
+        double m = std::ceil(-static_cast<double>(s.capacity) * std::log(nextRate) / (ln2 * ln2));
+        s.bits = std::max<uint64_t>(64, static_cast<uint64_t>(m));
+        s.hashes = std::max(1u, static_cast<unsigned>(std::lround(m / static_cast<double>(s.capacity) * ln2)));
+        s.words.assign((s.bits + 63) / 64, 0);
+        slices.push_back(std::move(s));
+        nextCapacity *= 2;
+        nextRate /= 2;
+    }
+
+    std::vector<Slice> slices;
+    size_t             nextCapacity;
+    double             nextRate;
+    size_t             count = 0;
+};
+
+#endif // BLOOMFILTER_HPP
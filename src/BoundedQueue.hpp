@@ -0,0 +1,194 @@
+// src/BoundedQueue.hpp
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Ограниченная lock-free очередь MPMC (кольцевой буфер Вьюкова).
+// Быстрый путь push/pop — один CAS по своему индексу; индексы производителей
+// и потребителей разнесены по разным кэш-линиям. Блокирующие push/pop сначала
+// крутятся, затем паркуются на condition_variable — мьютекс трогается только
+// при переполнении/опустошении и при наличии спящих потоков.
+template <typename T>
+class BoundedQueue {
+public:
+    // Ёмкость округляется вверх до степени двойки
+    explicit BoundedQueue(size_t capacity)
+    {
+        size_t cap = 2;
+        while (cap < capacity)
+            cap <<= 1;
+        mask = cap - 1;
+        cells.reset(new Cell[cap]);
+        for (size_t i = 0; i < cap; ++i)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    bool tryPush(T&& value) {
+        if (!rawPush(value))
+            return false;
+        wake(consumersWaiting, notEmpty);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        if (!rawPop(out))
+            return false;
+        wake(producersWaiting, notFull);
+        return true;
+    }
+
+    // Забирает до max элементов без блокировки
+    size_t tryPopBulk(T* out, size_t max) {
+        size_t n = 0;
+        while (n < max && rawPop(out[n]))
+            ++n;
+        if (n)
+            wake(producersWaiting, notFull, n > 1);
+        return n;
+    }
+
+    // Блокируется, пока в очереди нет места
+    void push(T&& value) {
+        for (int i = 0; i < kSpins; ++i) {
+            if (tryPush(std::move(value)))
+                return;
+            std::this_thread::yield();
+        }
+        {
+            std::unique_lock<std::mutex> lock(parkMutex);
+            producersWaiting.fetch_add(1);
+            while (!rawPush(value))
+                notFull.wait(lock);
+            producersWaiting.fetch_sub(1);
+        }
+        wake(consumersWaiting, notEmpty);
+    }
+
+    // Блокируется, пока очередь пуста. false — очередь закрыта и опустошена.
+    bool pop(T& out) {
+        for (int i = 0; i < kSpins; ++i) {
+            if (tryPop(out))
+                return true;
+            if (isClosed())
+                return tryPop(out);
+            std::this_thread::yield();
+        }
+        bool ok = false;
+        {
+            std::unique_lock<std::mutex> lock(parkMutex);
+            consumersWaiting.fetch_add(1);
+            while (!(ok = rawPop(out)) && !isClosed())
+                notEmpty.wait(lock);
+            consumersWaiting.fetch_sub(1);
+        }
+        if (!ok)
+            return tryPop(out);
+        wake(producersWaiting, notFull);
+        return true;
+    }
+
+    // Производителей больше не будет: потребители дочитывают остаток и получают false
+    void close() {
+        closed.store(true);
+        std::lock_guard<std::mutex> lock(parkMutex);
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    bool isClosed() const { return closed.load(); }
+
+    // Примерная длина очереди (для статистики)
+    size_t sizeApprox() const {
+        size_t e = enqueuePos.load(std::memory_order_relaxed);
+        size_t d = dequeuePos.load(std::memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+
+private:
+    static constexpr int kSpins = 64;
+    static constexpr size_t kCacheLine = 64;
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    bool rawPush(T& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // очередь заполнена
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool rawPop(T& out) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // очередь пуста
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Будит одного спящего, только если такие есть: быстрый путь мьютекс не трогает
+    void wake(std::atomic<int>& waiting, std::condition_variable& cv, bool all = false) {
+        // Барьер упорядочивает запись ячейки и чтение счётчика спящих (пара к fetch_add при парковке)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load() > 0) {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            if (all)
+                cv.notify_all();
+            else
+                cv.notify_one();
+        }
+    }
+
+    alignas(kCacheLine) std::atomic<size_t> enqueuePos{0};
+    alignas(kCacheLine) std::atomic<size_t> dequeuePos{0};
+    alignas(kCacheLine) std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+
+    alignas(kCacheLine) std::atomic<bool> closed{false};
+    std::atomic<int> producersWaiting{0};
+    std::atomic<int> consumersWaiting{0};
+    std::mutex parkMutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+#endif // BOUNDEDQUEUE_HPP
@@ -0,0 +1,166 @@
+// src/CaseSearch.cpp
+#include "CaseSearch.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CASESEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+inline unsigned char lowerAscii(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+}
+
+// Маска для сравнения байта с символом иглы: для букв OR 0x20 сворачивает регистр,
+// для остальных символов сравнение точное (иначе, например, '@' не нашёлся бы никогда)
+inline unsigned char foldMask(unsigned char c) {
+    return (c >= 'a' && c <= 'z') ? 0x20 : 0x00;
+}
+
+inline bool equalFolded(const char* hay, const char* needle, size_t m) {
+    for (size_t j = 0; j < m; ++j) {
+        if (lowerAscii(static_cast<unsigned char>(hay[j])) != static_cast<unsigned char>(needle[j]))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+CaseSearch::FindFn CaseSearch::findFn = CaseSearch::resolve();
+
+size_t CaseSearch::findScalar(const char* hay, size_t n, const char* needle, size_t m) {
+    if (m == 0)
+        return 0;
+    if (m > n)
+        return npos;
+    const unsigned char first = static_cast<unsigned char>(needle[0]);
+    const unsigned char mask  = foldMask(first);
+    for (size_t i = 0; i + m <= n; ++i) {
+        if ((static_cast<unsigned char>(hay[i]) | mask) == first &&
+            equalFolded(hay + i + 1, needle + 1, m - 1))
+            return i;
+    }
+    return npos;
+}
+
+#ifdef CASESEARCH_X86
+
+size_t CaseSearch::findSse2(const char* hay, size_t n, const char* needle, size_t m) {
+    if (m < 2 || m > n)
+        return findScalar(hay, n, needle, m);
+
+    const unsigned char f = static_cast<unsigned char>(needle[0]);
+    const unsigned char l = static_cast<unsigned char>(needle[m - 1]);
+    const __m128i first  = _mm_set1_epi8(static_cast<char>(f));
+    const __m128i last   = _mm_set1_epi8(static_cast<char>(l));
+    const __m128i fmask  = _mm_set1_epi8(static_cast<char>(foldMask(f)));
+    const __m128i lmask  = _mm_set1_epi8(static_cast<char>(foldMask(l)));
+
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + m - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, fmask), first),
+                                   _mm_cmpeq_epi8(_mm_or_si128(b, lmask), last));
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        while (bits) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(bits));
+            if (equalFolded(hay + i + bit + 1, needle + 1, m - 2))
+                return i + bit;
+            bits &= bits - 1;
+        }
+    }
+    size_t rest = findScalar(hay + i, n - i, needle, m);
+    return rest == npos ? npos : i + rest;
+}
+
+__attribute__((target("avx2")))
+size_t CaseSearch::findAvx2(const char* hay, size_t n, const char* needle, size_t m) {
+    if (m < 2 || m > n)
+        return findScalar(hay, n, needle, m);
+
+    const unsigned char f = static_cast<unsigned char>(needle[0]);
+    const unsigned char l = static_cast<unsigned char>(needle[m - 1]);
+    const __m256i first  = _mm256_set1_epi8(static_cast<char>(f));
+    const __m256i last   = _mm256_set1_epi8(static_cast<char>(l));
+    const __m256i fmask  = _mm256_set1_epi8(static_cast<char>(foldMask(f)));
+    const __m256i lmask  = _mm256_set1_epi8(static_cast<char>(foldMask(l)));
+
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i + m - 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(a, fmask), first),
+                                      _mm256_cmpeq_epi8(_mm256_or_si256(b, lmask), last));
+        uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        while (bits) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(bits));
+            if (equalFolded(hay + i + bit + 1, needle + 1, m - 2))
+                return i + bit;
+            bits &= bits - 1;
+        }
+    }
+    size_t rest = findSse2(hay + i, n - i, needle, m);
+    return rest == npos ? npos : i + rest;
+}
+
+bool CaseSearch::supported(Impl impl) {
+    // Может вызываться из статической инициализации — до конструкторов libgcc
+    __builtin_cpu_init();
+    switch (impl) {
+    case Impl::Avx2: return __builtin_cpu_supports("avx2");
+    case Impl::Sse2: return __builtin_cpu_supports("sse2");
+    default:         return true;
+    }
+}
+
+#else // !CASESEARCH_X86
+
+size_t CaseSearch::findSse2(const char* hay, size_t n, const char* needle, size_t m) {
+    return findScalar(hay, n, needle, m);
+}
+
+size_t CaseSearch::findAvx2(const char* hay, size_t n, const char* needle, size_t m) {
+    return findScalar(hay, n, needle, m);
+}
+
+bool CaseSearch::supported(Impl impl) {
+    return impl == Impl::Scalar;
+}
+
+#endif // CASESEARCH_X86
+
+CaseSearch::Impl CaseSearch::best() {
+    if (supported(Impl::Avx2)) return Impl::Avx2;
+    if (supported(Impl::Sse2)) return Impl::Sse2;
+    return Impl::Scalar;
+}
+
+const char* CaseSearch::name(Impl impl) {
+    switch (impl) {
+    case Impl::Avx2: return "avx2";
+    case Impl::Sse2: return "sse2";
+    default:         return "scalar";
+    }
+}
+
+CaseSearch::FindFn CaseSearch::resolve() {
+    switch (best()) {
+    case Impl::Avx2: return &CaseSearch::findAvx2;
+    case Impl::Sse2: return &CaseSearch::findSse2;
+    default:         return &CaseSearch::findScalar;
+    }
+}
+
+size_t CaseSearch::find(Impl impl, const char* hay, size_t n, const char* needle, size_t m) {
+    if (!supported(impl))
+        impl = Impl::Scalar;
+    switch (impl) {
+    case Impl::Avx2: return findAvx2(hay, n, needle, m);
+    case Impl::Sse2: return findSse2(hay, n, needle, m);
+    default:         return findScalar(hay, n, needle, m);
+    }
+}
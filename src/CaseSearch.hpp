@@ -0,0 +1,39 @@
+// src/CaseSearch.hpp
+#ifndef CASESEARCH_HPP
+#define CASESEARCH_HPP
+
+#include <cstddef>
+
+// Регистронезависимый (ASCII) поиск подстроки без промежуточной копии в нижнем регистре.
+// Векторные версии фильтруют кандидатов по первому и последнему байту иглы
+// (как в быстрых реализациях memmem) и сверяют середину только для совпавших позиций.
+// Реализация выбирается один раз по возможностям процессора; скалярная — переносимый запасной вариант.
+class CaseSearch {
+public:
+    enum class Impl { Scalar, Sse2, Avx2 };
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // needle должна быть в нижнем регистре. Возвращает смещение первого вхождения или npos.
+    static size_t find(const char* hay, size_t n, const char* needle, size_t m) {
+        return findFn(hay, n, needle, m);
+    }
+
+    // Явный выбор реализации (для бенчмарков); недоступная реализация заменяется скалярной
+    static size_t find(Impl impl, const char* hay, size_t n, const char* needle, size_t m);
+
+    static Impl        best();
+    static bool        supported(Impl impl);
+    static const char* name(Impl impl);
+
+private:
+    using FindFn = size_t (*)(const char*, size_t, const char*, size_t);
+    static FindFn findFn;
+
+    static size_t findScalar(const char* hay, size_t n, const char* needle, size_t m);
+    static size_t findSse2(const char* hay, size_t n, const char* needle, size_t m);
+    static size_t findAvx2(const char* hay, size_t n, const char* needle, size_t m);
+    static FindFn resolve();
+};
+
+#endif // CASESEARCH_HPP
@@ -0,0 +1,113 @@
+// src/ConcurrencyController.cpp
+#include "ConcurrencyController.hpp"
+#include "Logger.hpp"
+#include <sys/resource.h>
+#include <algorithm>
+#include <fstream>
+
+namespace {
+// Меньше наблюдений за интервал — решение о перегрузке не принимается
+constexpr size_t kMinSamples = 8;
+// Дескрипторы, оставляемые процессу сверх передач (файлы, epoll, DNS и т.п.)
+constexpr size_t kReservedFds = 64;
+}
+
+ConcurrencyController::ConcurrencyController(const Settings& s)
+    : settings(s)
+{
+    settings.minLimit = std::max<size_t>(settings.minLimit, 1);
+    settings.maxLimit = std::max(settings.maxLimit, settings.minLimit);
+    current = std::min(std::max(settings.initial, settings.minLimit), settings.maxLimit);
+    settledAvg = static_cast<double>(current);
+}
+
+void ConcurrencyController::onComplete(const HttpResponse& resp) {
+    ++completions;
+    bool connectFailure = false;
+    switch (resp.result) {
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_SSL_CONNECT_ERROR:
+        connectFailure = true;
+        break;
+    case CURLE_OPERATION_TIMEDOUT:
+        connectFailure = resp.timings.connect <= 0 || resp.evicted == Eviction::Connect ||
+                         resp.evicted == Eviction::Tls;
+        break;
+    default:
+        break;
+    }
+    if (connectFailure) {
+        ++connectErrors;
+    } else if (resp.timings.connect > resp.timings.dns) {
+        // Время TCP-рукопожатия без DNS — оценка RTT до сервера
+        rttSumUs += static_cast<double>(resp.timings.connect - resp.timings.dns);
+        ++rttSamples;
+    }
+}
+
+bool ConcurrencyController::update(uint64_t nowMs) {
+    if (nowMs - intervalStart < settings.intervalMs)
+        return false;
+    intervalStart = nowMs;
+
+    size_t before = current;
+    bool saturated = peakActive >= current;
+    bool congested = false;
+
+    if (completions >= kMinSamples) {
+        double errorRate = static_cast<double>(connectErrors) / static_cast<double>(completions);
+        if (baseErrorRate < 0)
+            baseErrorRate = errorRate;
+        // Мёртвые домены дают постоянный фон ошибок; перегрузка — его заметный рост
+        if (errorRate > baseErrorRate * 1.5 + 0.05)
+            congested = true;
+        baseErrorRate = baseErrorRate * 0.9 + errorRate * 0.1;
+    }
+    if (rttSamples >= kMinSamples) {
+        double rtt = rttSumUs / static_cast<double>(rttSamples);
+        if (minRttUs <= 0 || rtt < minRttUs)
+            minRttUs = rtt;
+        else if (rtt > minRttUs * 2.5 && rtt > minRttUs + 20000)
+            congested = true;
+        minRttUs *= 1.02; // минимум медленно забывается: маршруты и хосты меняются
+    }
+
+    if (congested) {
+        current = std::max(settings.minLimit, current * 3 / 4);
+        congestedOnce = true;
+    } else if (saturated) {
+        size_t step = congestedOnce ? std::max<size_t>(1, current / 16) : std::max<size_t>(1, current / 2);
+        current = std::min(settings.maxLimit, current + step);
+    }
+    settledAvg = settledAvg * 0.8 + static_cast<double>(current) * 0.2;
+
+    if (current != before)
+        Logger::debug("ConcurrencyController: %zu -> %zu (завершено %zu, ошибок соединения %zu, RTT %.1f мс)",
+                      before, current, completions, connectErrors,
+                      rttSamples ? rttSumUs / static_cast<double>(rttSamples) / 1000.0 : 0.0);
+
+    completions = connectErrors = rttSamples = 0;
+    rttSumUs = 0;
+    peakActive = 0;
+    return current != before;
+}
+
+size_t ConcurrencyController::resourceCap(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    size_t cap = SIZE_MAX;
+
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+        size_t fds = static_cast<size_t>(rl.rlim_cur);
+        cap = fds > kReservedFds ? fds - kReservedFds : 1;
+    }
+
+    // Каждое исходящее соединение занимает локальный порт из диапазона
+    std::ifstream in("/proc/sys/net/ipv4/ip_local_port_range");
+    long lo = 0, hi = 0;
+    if (in >> lo >> hi && hi > lo)
+        cap = std::min(cap, static_cast<size_t>(hi - lo) * 4 / 5);
+
+    return std::max<size_t>(1, cap / threads);
+}
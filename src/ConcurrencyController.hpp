@@ -0,0 +1,61 @@
+// src/ConcurrencyController.hpp
+#ifndef CONCURRENCYCONTROLLER_HPP
+#define CONCURRENCYCONTROLLER_HPP
+
+#include "HttpClient.hpp"
+#include <curl/curl.h>
+#include <cstddef>
+#include <cstdint>
+
+// Адаптивный предел одновременных передач одного потока (--concurrency=auto).
+// Раз в интервал сравнивает наблюдения с долгосрочной базой:
+//   - доля ошибок соединения (отказы, таймауты и снятия на фазе connect/TLS, сбои DNS);
+//   - время установки соединения (оценка RTT) относительно медленно забываемого минимума.
+// Рост ошибок или RTT — перегрузка: предел умножается на 3/4. Иначе, если окно было
+// заполнено, предел растёт: до первой перегрузки в 1.5 раза за интервал, после — на 1/16.
+// Сверху предел ограничен ресурсами машины (см. resourceCap).
+class ConcurrencyController {
+public:
+    struct Settings {
+        size_t   initial = 32;
+        size_t   minLimit = 4;
+        size_t   maxLimit = 2000;
+        uint32_t intervalMs = 1000;
+    };
+
+    explicit ConcurrencyController(const Settings& s);
+
+    // Наблюдения цикла событий
+    void onComplete(const HttpResponse& resp);
+    void onWindow(size_t active) { if (active > peakActive) peakActive = active; }
+
+    // Пересчитывает предел раз в интервал; true — предел изменился
+    bool update(uint64_t nowMs);
+
+    size_t limit() const { return current; }
+    // Среднее значение предела за последние интервалы — на чём регулятор остановился
+    size_t settled() const { return static_cast<size_t>(settledAvg + 0.5); }
+
+    // Предел на поток, который выдержат дескрипторы (RLIMIT_NOFILE) и локальные порты
+    static size_t resourceCap(size_t threads);
+
+private:
+    Settings settings;
+    size_t   current;
+    uint64_t intervalStart = 0;
+    bool     congestedOnce = false;
+
+    // Наблюдения текущего интервала
+    size_t completions = 0;
+    size_t connectErrors = 0;
+    size_t rttSamples = 0;
+    double rttSumUs = 0;
+    size_t peakActive = 0;
+
+    // Долгосрочные базы
+    double baseErrorRate = -1;
+    double minRttUs = 0;
+    double settledAvg;
+};
+
+#endif // CONCURRENCYCONTROLLER_HPP
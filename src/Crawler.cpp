@@ -0,0 +1,471 @@
+// src/Crawler.cpp
+#include "Crawler.hpp"
+#include "Logger.hpp"
+#include "DomainLoader.hpp"
+#include "Worker.hpp"
+#include "CurlShare.hpp"
+#include "DnsResolver.hpp"
+#include "HostScheduler.hpp"
+#include "MappedInput.hpp"
+#include "ResultWriter.hpp"
+#include "Journal.hpp"
+#include "DomainNormalizer.hpp"
+#include "MemoryBudget.hpp"
+#include "Metrics.hpp"
+#include "StatsServer.hpp"
+#include "Sharding.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+static std::vector<std::string> parseListArgs(int argc, char* argv[], const std::string& prefix) {
+    std::vector<std::string> result;
+    for (int i = 4; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind(prefix, 0) == 0) {
+            std::string value = arg.substr(prefix.size());
+            size_t pos = 0;
+            while ((pos = value.find(',')) != std::string::npos) {
+                result.push_back(value.substr(0, pos));
+                value.erase(0, pos + 1);
+            }
+            if (!value.empty())
+                result.push_back(value);
+        }
+    }
+    return result;
+}
+
+static std::vector<std::string> parseContainsArgs(int argc, char* argv[]) {
+    return parseListArgs(argc, argv, "--contains=");
+}
+
+static bool hasFlag(int argc, char* argv[], const std::string& flag) {
+    for (int i = 4; i < argc; ++i) {
+        if (flag == argv[i])
+            return true;
+    }
+    return false;
+}
+
+// Возвращает значение опции вида --name=value (или пустую строку, если опции нет)
+static std::string findOption(int argc, char* argv[], const std::string& prefix) {
+    for (int i = 4; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind(prefix, 0) == 0)
+            return arg.substr(prefix.size());
+    }
+    return std::string();
+}
+
+// Завершение прогона на любом пути выхода: остановить фоновые потоки, дописать результаты
+// и журнал, закрыть файлы. Оставшийся joinable поток записи завершил бы процесс через std::terminate.
+struct RunTeardown {
+    FILE* output = nullptr;
+    bool  curl = false;
+
+    ~RunTeardown() {
+        Metrics::stop();
+        StatsServer::stop();
+        ResultWriter::stop();
+        Journal::close();
+        if (curl)
+            CurlShare::cleanup();
+        if (output)
+            std::fclose(output);
+        Logger::shutdown();
+    }
+};
+
+int Crawler::run(int argc, char* argv[]) {
+    if (argc < 4) {
+        Logger::error("Usage: %s <domain_file> <output_file> <threads> [debug] [--contains=word1,word2,...] [--rules=FILE] [--concurrency=N|auto] [--max-concurrency=N] [--engine=epoll|poll] [--resolve-ahead] [--dns=ip[:port],...] [--dns-inflight=N] [--queue-size=N] [--input-mode=stream|mmap] [--flush-ms=N] [--fsync] [--format=plain|csv|ndjson|binary] [--journal=FILE] [--resume] [--host-conns=N] [--host-rps=R] [--ip-conns=N] [--ip-rps=R] [--sched-backlog=N] [--retries=N] [--retry-delay-ms=N] [--connect-timeout-ms=N] [--tls-timeout-ms=N] [--ttfb-timeout-ms=N] [--total-timeout-ms=N] [--min-speed=BYTES[:SECONDS]] [--max-bytes=N] [--memory-budget=MB] [--no-compression] [--scheme=http|https-first|auto] [--stats=[ip:]port] [--progress=SECONDS] [--logfile=FILE] [--dedup[=exact|bloom[:FPR]]] [--fold-www] [--strip-paths] [--shard=i/N] [--pull=host:port]", argv[0]);
+        return 1;
+    }
+
+    std::string domainFile = argv[1];
+    std::string outFile    = argv[2];
+    int numThreads         = std::atoi(argv[3]);
+
+    if (numThreads <= 0) {
+        Logger::error("Invalid thread count: %d", numThreads);
+        return 1;
+    }
+
+    Logger::Level lvl = Logger::Level::Info;
+    for (int i = 4; i < argc; ++i) {
+        if (std::string(argv[i]) == "debug") {
+            lvl = Logger::Level::Debug;
+            break;
+        }
+    }
+
+    // Журнал пишет фоновый поток; --logfile перенаправляет его из stderr в файл
+    if (!Logger::init(lvl, findOption(argc, argv, "--logfile=")))
+        return 1;
+    std::vector<std::string> matchWords = parseContainsArgs(argc, argv);
+    Worker::setMatchWords(matchWords);
+
+    // Файл правил: компилируется до старта, ошибка разбора — отказ от запуска
+    std::string rulesArg = findOption(argc, argv, "--rules=");
+    if (!rulesArg.empty()) {
+        RuleSet rules;
+        std::string error;
+        if (!rules.load(rulesArg, error)) {
+            Logger::error("Invalid rules file %s: %s", rulesArg.c_str(), error.c_str());
+            return 1;
+        }
+        Logger::info("Loaded %zu rules from %s", rules.size(), rulesArg.c_str());
+        Worker::setRules(std::move(rules));
+    }
+
+    // Число одновременных передач на поток
+    std::string concurrencyArg = findOption(argc, argv, "--concurrency=");
+    if (concurrencyArg == "auto") {
+        // Адаптивный режим: старт с 32, потолок — --max-concurrency и ресурсы машины
+        std::string maxArg = findOption(argc, argv, "--max-concurrency=");
+        int maxConcurrency = maxArg.empty() ? 2000 : std::atoi(maxArg.c_str());
+        if (maxConcurrency <= 0) {
+            Logger::error("Invalid max concurrency: %s", maxArg.c_str());
+            return 1;
+        }
+        Worker::setAdaptiveConcurrency(32, static_cast<size_t>(maxConcurrency));
+    } else if (!concurrencyArg.empty()) {
+        int concurrency = std::atoi(concurrencyArg.c_str());
+        if (concurrency <= 0) {
+            Logger::error("Invalid concurrency: %s", concurrencyArg.c_str());
+            return 1;
+        }
+        Worker::setConcurrency(static_cast<size_t>(concurrency));
+    }
+
+    // Движок цикла событий: epoll (по умолчанию) или poll — для сравнения
+    std::string engineArg = findOption(argc, argv, "--engine=");
+    if (engineArg == "poll") {
+        Worker::setEngine(TransferPool::Engine::Poll);
+    } else if (!engineArg.empty() && engineArg != "epoll") {
+        Logger::error("Unknown engine: %s (expected epoll or poll)", engineArg.c_str());
+        return 1;
+    }
+
+    // Ёмкость очереди доменов перед воркерами (загрузчик ждёт, если она заполнена)
+    std::string queueArg = findOption(argc, argv, "--queue-size=");
+    if (!queueArg.empty()) {
+        int queueSize = std::atoi(queueArg.c_str());
+        if (queueSize <= 0) {
+            Logger::error("Invalid queue size: %s", queueArg.c_str());
+            return 1;
+        }
+        Worker::setQueueCapacity(static_cast<size_t>(queueSize));
+    }
+
+    // Повторы временных ошибок: число повторов на домен и начальная задержка
+    RetryPolicy::Settings retry;
+    std::string retriesArg = findOption(argc, argv, "--retries=");
+    if (!retriesArg.empty()) {
+        retry.maxRetries = std::atoi(retriesArg.c_str());
+        if (retry.maxRetries < 0 || (retry.maxRetries == 0 && retriesArg != "0")) {
+            Logger::error("Invalid retry count: %s", retriesArg.c_str());
+            return 1;
+        }
+    }
+    std::string retryDelayArg = findOption(argc, argv, "--retry-delay-ms=");
+    if (!retryDelayArg.empty()) {
+        retry.baseDelayMs = std::atoi(retryDelayArg.c_str());
+        if (retry.baseDelayMs <= 0) {
+            Logger::error("Invalid retry delay: %s", retryDelayArg.c_str());
+            return 1;
+        }
+    }
+    Worker::setRetryPolicy(retry);
+
+    // Сроки фаз передачи от её начала (0 — без ограничения) и минимальная скорость
+    TransferPool::Deadlines deadlines;
+    struct { const char* name; uint32_t* value; } deadlineArgs[] = {
+        {"--connect-timeout-ms=", &deadlines.connectMs},
+        {"--tls-timeout-ms=",     &deadlines.tlsMs},
+        {"--ttfb-timeout-ms=",    &deadlines.firstByteMs},
+        {"--total-timeout-ms=",   &deadlines.totalMs},
+    };
+    for (auto& d : deadlineArgs) {
+        std::string arg = findOption(argc, argv, d.name);
+        if (arg.empty())
+            continue;
+        long v = std::atol(arg.c_str());
+        if (v < 0 || (v == 0 && arg != "0")) {
+            Logger::error("Invalid timeout %s%s", d.name, arg.c_str());
+            return 1;
+        }
+        *d.value = static_cast<uint32_t>(v);
+    }
+    std::string speedArg = findOption(argc, argv, "--min-speed=");
+    if (!speedArg.empty()) {
+        long bytes = std::atol(speedArg.c_str());
+        size_t colon = speedArg.find(':');
+        long seconds = colon == std::string::npos ? 10 : std::atol(speedArg.c_str() + colon + 1);
+        if (bytes < 0 || seconds <= 0) {
+            Logger::error("Invalid minimum speed: %s", speedArg.c_str());
+            return 1;
+        }
+        deadlines.minBytesPerSec = static_cast<uint32_t>(bytes);
+        deadlines.speedWindowMs = static_cast<uint32_t>(seconds * 1000);
+    }
+    Worker::setDeadlines(deadlines);
+
+    // Экономия трафика: бюджет тела, сжатая передача, выбор схемы
+    std::string maxBytesArg = findOption(argc, argv, "--max-bytes=");
+    if (!maxBytesArg.empty()) {
+        long long maxBytes = std::atoll(maxBytesArg.c_str());
+        if (maxBytes <= 0) {
+            Logger::error("Invalid byte budget: %s", maxBytesArg.c_str());
+            return 1;
+        }
+        Worker::setMaxBytes(static_cast<size_t>(maxBytes));
+    }
+    // Общий бюджет буферов ответов и невыписанных результатов, МБ
+    std::string budgetArg = findOption(argc, argv, "--memory-budget=");
+    if (!budgetArg.empty()) {
+        long long budgetMb = std::atoll(budgetArg.c_str());
+        if (budgetMb <= 0) {
+            Logger::error("Invalid memory budget: %s", budgetArg.c_str());
+            return 1;
+        }
+        MemoryBudget::setLimit(static_cast<size_t>(budgetMb) << 20);
+    }
+    Worker::setCompression(!hasFlag(argc, argv, "--no-compression"));
+    std::string schemeArg = findOption(argc, argv, "--scheme=");
+    if (schemeArg == "https-first") {
+        Worker::setScheme(Worker::Scheme::HttpsFirst);
+    } else if (schemeArg == "auto") {
+        Worker::setScheme(Worker::Scheme::Auto);
+    } else if (!schemeArg.empty() && schemeArg != "http") {
+        Logger::error("Unknown scheme strategy: %s (expected http, https-first or auto)", schemeArg.c_str());
+        return 1;
+    }
+
+    // Лимиты вежливости на регистрируемый домен и на IP: включают стадию HostScheduler
+    HostScheduler::Limits limits;
+    bool politeness = false;
+    const char* limitNames[] = {"--host-conns=", "--host-rps=", "--ip-conns=", "--ip-rps="};
+    double limitValues[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        std::string arg = findOption(argc, argv, limitNames[i]);
+        if (arg.empty())
+            continue;
+        limitValues[i] = std::atof(arg.c_str());
+        if (limitValues[i] <= 0) {
+            Logger::error("Invalid limit %s%s", limitNames[i], arg.c_str());
+            return 1;
+        }
+        politeness = true;
+    }
+    limits.hostConns = static_cast<size_t>(limitValues[0]);
+    limits.hostRps   = limitValues[1];
+    limits.ipConns   = static_cast<size_t>(limitValues[2]);
+    limits.ipRps     = limitValues[3];
+    std::string backlogArg = findOption(argc, argv, "--sched-backlog=");
+    int schedBacklog = backlogArg.empty() ? 1000000 : std::atoi(backlogArg.c_str());
+    if (schedBacklog <= 0) {
+        Logger::error("Invalid scheduler backlog: %s", backlogArg.c_str());
+        return 1;
+    }
+    // Предварительное разрешение имён: серверы и число запросов в полёте проверяются
+    // до запуска стадий — остановленный на полпути конвейер не завершается
+    std::vector<std::string> dnsServers = parseListArgs(argc, argv, "--dns=");
+    bool resolveAhead = hasFlag(argc, argv, "--resolve-ahead") || !dnsServers.empty();
+    std::string inflightArg = findOption(argc, argv, "--dns-inflight=");
+    int dnsInflight = inflightArg.empty() ? 1000 : std::atoi(inflightArg.c_str());
+    if (dnsInflight <= 0) {
+        Logger::error("Invalid DNS in-flight limit: %s", inflightArg.c_str());
+        return 1;
+    }
+    // Очередь за планировщиком держим короткой, чтобы лимиты действовали на момент старта запроса
+    if (politeness && queueArg.empty())
+        Worker::setQueueCapacity(std::max<size_t>(1024, static_cast<size_t>(numThreads) * 64));
+
+    // Прогон на нескольких узлах: --shard=i/N — своя доля входа по регистрируемому домену;
+    // --pull=host:port — вход кусками от координатора (ShardTool coordinate), domain_file не читается
+    std::string shardArg = findOption(argc, argv, "--shard=");
+    if (!shardArg.empty() && !Sharding::parse(shardArg)) {
+        Logger::error("Invalid shard: %s (expected i/N with 0 <= i < N)", shardArg.c_str());
+        return 1;
+    }
+    std::string pullArg = findOption(argc, argv, "--pull=");
+    if (!pullArg.empty() && !shardArg.empty()) {
+        Logger::error("--pull cannot be combined with --shard: the coordinator already splits the input");
+        return 1;
+    }
+
+    // Нормализация входа (регистр, IDN, www., пути) и отсев повторов перед остальными стадиями
+    DomainNormalizer::Settings normalize;
+    normalize.foldWww = hasFlag(argc, argv, "--fold-www");
+    normalize.stripPaths = hasFlag(argc, argv, "--strip-paths");
+    std::string dedupArg = findOption(argc, argv, "--dedup=");
+    if (hasFlag(argc, argv, "--dedup") || dedupArg == "exact") {
+        normalize.dedup = DomainNormalizer::Dedup::Exact;
+    } else if (dedupArg.rfind("bloom", 0) == 0) {
+        normalize.dedup = DomainNormalizer::Dedup::Bloom;
+        if (dedupArg.size() > 5) {
+            normalize.falsePositiveRate = dedupArg[5] == ':' ? std::atof(dedupArg.c_str() + 6) : 0;
+            if (normalize.falsePositiveRate <= 0 || normalize.falsePositiveRate >= 1) {
+                Logger::error("Invalid bloom filter false positive rate: %s", dedupArg.c_str());
+                return 1;
+            }
+        }
+        // Первый срез фильтра — по размеру входа (~16 байт на строку, доля своего шарда); дальше фильтр растёт сам
+        struct stat st;
+        if (stat(domainFile.c_str(), &st) == 0)
+            normalize.expected = static_cast<size_t>(st.st_size) / 16 / Sharding::shardCount();
+    } else if (!dedupArg.empty()) {
+        Logger::error("Unknown dedup mode: %s (expected exact or bloom[:FPR])", dedupArg.c_str());
+        return 1;
+    }
+    bool normalization = normalize.foldWww || normalize.stripPaths || normalize.dedup != DomainNormalizer::Dedup::None;
+
+    // Режим чтения входа: stream — DomainLoader и общая очередь; mmap — файл отображается
+    // в память и делится на диапазоны по потокам
+    std::string inputMode = findOption(argc, argv, "--input-mode=");
+    if (!inputMode.empty() && inputMode != "stream" && inputMode != "mmap") {
+        Logger::error("Unknown input mode: %s (expected stream or mmap)", inputMode.c_str());
+        return 1;
+    }
+    if (inputMode == "mmap" &&
+        (resolveAhead || politeness ||
+         normalization)) {
+        Logger::error("--input-mode=mmap cannot be combined with --resolve-ahead/--dns, host/ip limits or --dedup/--fold-www/--strip-paths");
+        return 1;
+    }
+    if (inputMode == "mmap" && !pullArg.empty()) {
+        Logger::error("--input-mode=mmap cannot be combined with --pull");
+        return 1;
+    }
+
+    // Результаты пишет отдельный поток пачками; интервал сброса и fdatasync настраиваются
+    std::string flushArg = findOption(argc, argv, "--flush-ms=");
+    int flushMs = flushArg.empty() ? 1000 : std::atoi(flushArg.c_str());
+    if (flushMs <= 0) {
+        Logger::error("Invalid flush interval: %s", flushArg.c_str());
+        return 1;
+    }
+    // Формат результатов: plain — только совпавшие домены; остальные — запись на каждый домен
+    ResultFormat::Format format = ResultFormat::Format::Plain;
+    std::string formatArg = findOption(argc, argv, "--format=");
+    if (!formatArg.empty() && !ResultFormat::parse(formatArg, format)) {
+        Logger::error("Unknown output format: %s (expected plain, csv, ndjson or binary)", formatArg.c_str());
+        return 1;
+    }
+    Worker::setOutputFormat(format);
+    // Интервал строки прогресса (0 — выключена)
+    std::string progressArg = findOption(argc, argv, "--progress=");
+    int progressSec = progressArg.empty() ? 0 : std::atoi(progressArg.c_str());
+    if (progressSec < 0 || (progressSec == 0 && !progressArg.empty() && progressArg != "0")) {
+        Logger::error("Invalid progress interval: %s", progressArg.c_str());
+        return 1;
+    }
+    // Вход mmap открывается до файлов результатов и журнала: без входа прошлые результаты не затираются
+    MappedInput input;
+    if (inputMode == "mmap" && !input.open(domainFile))
+        return 1;
+
+    // Журнал завершённых доменов: при --resume выполненные домены пропускаются,
+    // а результаты дописываются в конец существующего файла
+    std::string journalFile = findOption(argc, argv, "--journal=");
+    bool resume = hasFlag(argc, argv, "--resume");
+    if (resume && journalFile.empty()) {
+        Logger::error("--resume requires --journal=FILE");
+        return 1;
+    }
+    // Дальше запускаются потоки и открываются файлы: любой выход из run() проходит через teardown
+    RunTeardown teardown;
+
+    // Эндпоинт Prometheus — до файлов результатов: занятый порт --stats не затирает прошлый прогон
+    Metrics::addGauge("crawler_queue_depth", "Domains waiting in the worker queue.",
+                      [] { return static_cast<double>(Worker::queueDepth()); });
+    if (MemoryBudget::limitBytes())
+        Metrics::addGauge("crawler_memory_budget_used_bytes", "Bytes charged against --memory-budget.",
+                          [] { return static_cast<double>(MemoryBudget::usedBytes()); });
+    std::string statsArg = findOption(argc, argv, "--stats=");
+    if (!statsArg.empty() && !StatsServer::start(statsArg))
+        return 1;
+
+    if (!journalFile.empty() && !Journal::open(journalFile, resume))
+        return 1;
+
+    FILE* outfp = std::fopen(outFile.c_str(), resume ? "a" : "w");
+    if (!outfp) {
+        Logger::error("Failed to open output file: %s", outFile.c_str());
+        return 1;
+    }
+    teardown.output = outfp;
+    std::fseek(outfp, 0, SEEK_END);
+    bool outputEmpty = std::ftell(outfp) == 0;
+
+    ResultWriter::start(fileno(outfp), flushMs, hasFlag(argc, argv, "--fsync"),
+                        outputEmpty ? ResultFormat::header(format, Worker::keywordMatcher(), Worker::ruleSet()) : std::string());
+
+    // Глобальная инициализация libcurl и общий кэш DNS/TLS — до запуска потоков
+    CurlShare::init();
+    teardown.curl = true;
+
+    // Периодическая строка прогресса
+    Metrics::startProgress(progressSec);
+
+    if (inputMode == "mmap") {
+        Worker::setMappedInput(&input);
+        Worker::startThreads(numThreads);
+        Worker::joinThreads();
+        if (Sharding::enabled())
+            Logger::info("Шард %zu/%zu: строк других узлов пропущено %zu",
+                         Sharding::shardIndex(), Sharding::shardCount(), Sharding::skippedCount());
+        return 0;
+    }
+
+    DomainLoader loader(domainFile);
+    std::unique_ptr<DomainNormalizer> normalizer;
+    if (normalization) {
+        normalizer = std::make_unique<DomainNormalizer>(normalize);
+        loader.setNormalizer(normalizer.get());
+    }
+    if (!pullArg.empty())
+        loader.setCoordinator(pullArg);
+
+    // Опциональная стадия вежливости перед воркерами: [DnsResolver] -> HostScheduler -> Worker
+    std::unique_ptr<HostScheduler> scheduler;
+    if (politeness) {
+        scheduler = std::make_unique<HostScheduler>(limits, static_cast<size_t>(schedBacklog));
+        HostScheduler* hs = scheduler.get();
+        loader.setSink([hs](const std::string& line) { hs->enqueue(line); },
+                       [hs]() { hs->notifyFinished(); });
+        Worker::setCompletionSink([hs](uint64_t ticket) { hs->release(ticket); });
+        scheduler->start();
+    }
+
+    // Опциональная стадия предварительного разрешения имён: DomainLoader -> DnsResolver -> Worker
+    std::unique_ptr<DnsResolver> resolver;
+    if (resolveAhead) {
+        resolver = std::make_unique<DnsResolver>(dnsServers, static_cast<size_t>(dnsInflight));
+        DnsResolver* r = resolver.get();
+        loader.setSink([r](const std::string& line) { r->enqueue(line); },
+                       [r]() { r->notifyFinished(); });
+        if (HostScheduler* hs = scheduler.get())
+            resolver->setSink([hs](DomainTask&& task) { hs->enqueueTask(std::move(task)); },
+                              [hs]() { hs->notifyFinished(); });
+        resolver->start();
+    }
+
+    loader.start();
+    Worker::startThreads(numThreads);
+
+    // Worker::notifyFinished вызывает последняя стадия перед воркерами
+    loader.join();
+    if (resolver)
+        resolver->join();
+    if (scheduler)
+        scheduler->join();
+    Worker::joinThreads();
+    return 0;
+}
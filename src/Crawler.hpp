@@ -0,0 +1,13 @@
+// src/Crawler.hpp
+#ifndef CRAWLER_HPP
+#define CRAWLER_HPP
+
+// Разбор командной строки и полный прогон краулера. Вынесено из main, чтобы
+// бенчмарки и другие инструменты могли запускать краулер из библиотеки CrawlerCore.
+class Crawler {
+public:
+    // Аргументы — как у исполняемого файла (argv[0] — имя программы); возвращает код выхода
+    static int run(int argc, char* argv[]);
+};
+
+#endif // CRAWLER_HPP
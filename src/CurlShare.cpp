@@ -0,0 +1,41 @@
+// src/CurlShare.cpp
+#include "CurlShare.hpp"
+#include "Logger.hpp"
+
+CURLSH*    CurlShare::share = nullptr;
+std::mutex CurlShare::locks[CURL_LOCK_DATA_LAST];
+
+bool CurlShare::init() {
+    curl_global_init(CURL_GLOBAL_ALL);
+    share = curl_share_init();
+    if (!share) {
+        Logger::error("CurlShare: не удалось инициализировать curl_share");
+        return false;
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, CurlShare::lock);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, CurlShare::unlock);
+
+    CURLSHcode sc = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    if (sc != CURLSHE_OK)
+        Logger::error("CurlShare: DNS-кэш не разделяется: %s", curl_share_strerror(sc));
+    sc = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    if (sc != CURLSHE_OK)
+        Logger::error("CurlShare: кэш TLS-сессий не разделяется: %s", curl_share_strerror(sc));
+    return true;
+}
+
+void CurlShare::cleanup() {
+    if (share) {
+        curl_share_cleanup(share);
+        share = nullptr;
+    }
+    curl_global_cleanup();
+}
+
+void CurlShare::lock(CURL*, curl_lock_data data, curl_lock_access, void*) {
+    locks[data].lock();
+}
+
+void CurlShare::unlock(CURL*, curl_lock_data data, void*) {
+    locks[data].unlock();
+}
@@ -0,0 +1,31 @@
+// src/CurlShare.hpp
+#ifndef CURLSHARE_HPP
+#define CURLSHARE_HPP
+
+#include <curl/curl.h>
+#include <mutex>
+
+// Общий для всего процесса CURLSH: DNS-кэш и кэш TLS-сессий разделяются между
+// всеми потоками-воркерами, так что повторный запрос к тому же хосту (в том числе
+// после редиректа http://x -> https://www.x из другого потока) не делает холодный
+// DNS-запрос и полный TLS-handshake.
+// Кэш соединений остаётся у CURLM каждого потока: libcurl не поддерживает
+// разделение соединений между одновременно работающими потоками.
+class CurlShare {
+public:
+    // Вызывается из main до запуска потоков
+    static bool init();
+    static void cleanup();
+
+    // nullptr, если init() не вызывался или завершился ошибкой
+    static CURLSH* handle() { return share; }
+
+private:
+    static void lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock(CURL* handle, curl_lock_data data, void* userptr);
+
+    static CURLSH*    share;
+    static std::mutex locks[CURL_LOCK_DATA_LAST];
+};
+
+#endif // CURLSHARE_HPP
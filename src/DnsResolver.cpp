@@ -0,0 +1,433 @@
+// src/DnsResolver.cpp
+#include "DnsResolver.hpp"
+#include "Worker.hpp"
+#include "Logger.hpp"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace {
+
+constexpr int  kMaxAttempts = 3;
+constexpr auto kQueryTimeout = std::chrono::milliseconds(1500);
+// Запросы расходятся по нескольким исходным портам, а каждый порт живёт ограниченное
+// число запросов: к 16 битам DNS ID добавляется неизвестный атакующему порт
+constexpr size_t   kSockets = 8;
+constexpr size_t   kQueriesPerPort = 512;
+constexpr uint32_t kNoSlot = UINT32_MAX;
+
+bool parseServer(const std::string& spec, sockaddr_in& addr) {
+    std::string ip = spec;
+    int port = 53;
+    size_t colon = spec.find(':');
+    if (colon != std::string::npos) {
+        ip = spec.substr(0, colon);
+        port = std::atoi(spec.c_str() + colon + 1);
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    return port > 0 && port < 65536 && inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) == 1;
+}
+
+// IPv4-серверы из /etc/resolv.conf
+std::vector<std::string> systemServers() {
+    std::vector<std::string> out;
+    std::ifstream in("/etc/resolv.conf");
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string key, value;
+        if (ss >> key >> value && key == "nameserver")
+            out.push_back(value);
+    }
+    return out;
+}
+
+// Кодирует имя в формат DNS (метки с длиной). false — имя некорректно.
+bool encodeName(const std::string& host, std::string& out) {
+    if (host.empty() || host.size() > 253)
+        return false;
+    size_t start = 0;
+    while (start <= host.size()) {
+        size_t dot = host.find('.', start);
+        if (dot == std::string::npos)
+            dot = host.size();
+        size_t len = dot - start;
+        if (len == 0) {
+            // Допускаем только завершающую точку ("example.com.")
+            if (dot == host.size())
+                break;
+            return false;
+        }
+        if (len > 63)
+            return false;
+        out.push_back(static_cast<char>(len));
+        out.append(host, start, len);
+        start = dot + 1;
+    }
+    out.push_back('\0');
+    return true;
+}
+
+// Читает (возможно, сжатое) имя из ответа. Возвращает позицию за именем или 0 при ошибке.
+size_t readName(const unsigned char* msg, size_t len, size_t pos, std::string* name) {
+    size_t end = 0;
+    int jumps = 0;
+    while (pos < len) {
+        unsigned char l = msg[pos];
+        if (l == 0) {
+            return end ? end : pos + 1;
+        }
+        if ((l & 0xC0) == 0xC0) {
+            if (pos + 1 >= len || ++jumps > 16)
+                return 0;
+            if (!end)
+                end = pos + 2;
+            pos = static_cast<size_t>((l & 0x3F) << 8 | msg[pos + 1]);
+            continue;
+        }
+        if (pos + 1 + l > len)
+            return 0;
+        if (name) {
+            if (!name->empty())
+                name->push_back('.');
+            for (size_t i = 0; i < l; ++i)
+                name->push_back(static_cast<char>(std::tolower(msg[pos + 1 + i])));
+        }
+        pos += 1 + l;
+    }
+    return 0;
+}
+
+} // namespace
+
+DnsResolver::DnsResolver(const std::vector<std::string>& specs, size_t maxInFlight_)
+    : maxInFlight(std::min<size_t>(std::max<size_t>(maxInFlight_, 1), 65535))
+    , taskSink(&Worker::enqueueTask)
+    , unresolvableSink(&Worker::enqueueTask)
+    , doneSink(&Worker::notifyFinished)
+    , input(65536)
+{
+    std::vector<std::string> list = specs.empty() ? systemServers() : specs;
+    for (const auto& spec : list) {
+        sockaddr_in addr;
+        if (parseServer(spec, addr))
+            servers.push_back(addr);
+        else
+            Logger::error("DnsResolver: некорректный адрес DNS-сервера: %s", spec.c_str());
+    }
+
+    random.seed(std::random_device{}());
+    sockets.resize(kSockets);
+    for (Socket& s : sockets) {
+        if (!openSocket(s)) {
+            Logger::error("DnsResolver: не удалось создать UDP-сокет: %s", std::strerror(errno));
+            break;
+        }
+    }
+    if (servers.empty())
+        Logger::error("DnsResolver: нет DNS-серверов, домены передаются без разрешения");
+
+    pending.resize(maxInFlight);
+    freeSlots.reserve(maxInFlight);
+    for (size_t i = maxInFlight; i-- > 0;)
+        freeSlots.push_back(static_cast<uint16_t>(i));
+    slotById.assign(65536, kNoSlot);
+}
+
+DnsResolver::~DnsResolver() {
+    join();
+    for (Socket& s : sockets) {
+        if (s.fd >= 0)
+            ::close(s.fd);
+    }
+}
+
+// Новый сокет — новый случайный исходный порт (выбирает ядро при первой отправке)
+bool DnsResolver::openSocket(Socket& s) {
+    if (s.fd >= 0)
+        ::close(s.fd);
+    s.fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    s.sent = 0;
+    s.outstanding = 0;
+    return s.fd >= 0;
+}
+
+void DnsResolver::setSink(TaskSink onTask, DoneSink onDone) {
+    taskSink = std::move(onTask);
+    doneSink = std::move(onDone);
+}
+
+void DnsResolver::start() {
+    resolverThread = std::thread(&DnsResolver::run, this);
+}
+
+void DnsResolver::join() {
+    if (resolverThread.joinable())
+        resolverThread.join();
+}
+
+void DnsResolver::enqueue(const std::string& domain) {
+    input.push(std::string(domain));
+}
+
+void DnsResolver::notifyFinished() {
+    input.close();
+}
+
+// Снимает отображение ID текущей попытки; исчерпавший лимит сокет без ожидающих
+// ответов пересоздаётся с новым портом
+void DnsResolver::releaseQuery(Pending& p) {
+    if (!p.mapped)
+        return;
+    p.mapped = false;
+    slotById[p.queryId] = kNoSlot;
+    Socket& s = sockets[p.socket];
+    if (--s.outstanding == 0 && s.sent >= kQueriesPerPort && !openSocket(s))
+        Logger::error("DnsResolver: не удалось пересоздать UDP-сокет: %s", std::strerror(errno));
+}
+
+bool DnsResolver::sendQuery(uint16_t slot) {
+    Pending& p = pending[slot];
+    releaseQuery(p);
+
+    std::string msg;
+    msg.reserve(32 + p.host.size());
+    const unsigned char header[12] = {
+        0, 0,        // ID — ниже
+        0x01, 0x00,  // RD — рекурсивный запрос
+        0x00, 0x01,  // QDCOUNT = 1
+        0, 0, 0, 0, 0, 0
+    };
+    msg.append(reinterpret_cast<const char*>(header), sizeof(header));
+    if (!encodeName(p.host, msg))
+        return false;
+    const unsigned char tail[4] = {0x00, 0x01, 0x00, 0x01}; // QTYPE = A, QCLASS = IN
+    msg.append(reinterpret_cast<const char*>(tail), sizeof(tail));
+
+    // Случайный сокет из тех, что ещё не исчерпали лимит; если все ждут последних
+    // ответов перед пересозданием — любой рабочий
+    size_t si = random() % sockets.size();
+    for (size_t i = 0; i < sockets.size() && (sockets[si].fd < 0 || sockets[si].sent >= kQueriesPerPort); ++i)
+        si = (si + 1) % sockets.size();
+    for (size_t i = 0; i < sockets.size() && sockets[si].fd < 0; ++i)
+        si = (si + 1) % sockets.size();
+    Socket& sock = sockets[si];
+    if (sock.fd < 0)
+        return false;
+
+    // Свежий случайный ID на каждую попытку: поздний ответ на прошлую попытку не подходит
+    uint16_t id;
+    do {
+        id = static_cast<uint16_t>(random());
+    } while (slotById[id] != kNoSlot);
+    msg[0] = static_cast<char>(id >> 8);
+    msg[1] = static_cast<char>(id & 0xFF);
+    p.queryId = id;
+    p.socket = static_cast<uint16_t>(si);
+    p.mapped = true;
+    slotById[id] = slot;
+    ++sock.sent;
+    ++sock.outstanding;
+
+    // Повторные попытки уходят на следующий сервер из списка
+    p.server = static_cast<uint16_t>((slot + p.attempts) % servers.size());
+    const sockaddr_in& server = servers[p.server];
+    ssize_t n = ::sendto(sock.fd, msg.data(), msg.size(), 0,
+                         reinterpret_cast<const sockaddr*>(&server), sizeof(server));
+    ++p.attempts;
+    deadlines.push_back({slot, p.generation, std::chrono::steady_clock::now() + kQueryTimeout});
+    // Ошибку отправки (например, переполнен буфер сокета) обработает таймаут
+    return n >= 0 || errno == EAGAIN || errno == ENOBUFS;
+}
+
+void DnsResolver::complete(uint16_t slot, const std::string& address, bool drop) {
+    Pending& p = pending[slot];
+    releaseQuery(p);
+    if (drop) {
+        // Загрузки не будет, но результат и отметка в журнале нужны: воркер пишет их без передачи
+        ++nxdomain;
+        Logger::debug("DnsResolver: %s — NXDOMAIN, загрузка не нужна", p.host.c_str());
+        p.task.unresolvable = true;
+        unresolvableSink(std::move(p.task));
+    } else {
+        if (address.empty())
+            ++unresolved;
+        else
+            ++resolved;
+        p.task.address = address;
+        taskSink(std::move(p.task));
+    }
+    p.busy = false;
+    p.task = DomainTask();
+    ++p.generation;
+    freeSlots.push_back(slot);
+    --inFlight;
+}
+
+void DnsResolver::receive(uint16_t socket) {
+    unsigned char buf[1500];
+    while (true) {
+        // Сокет пересоздаётся в complete(), когда исчерпал лимит: fd читается заново
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t n = ::recvfrom(sockets[socket].fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+        if (n < 0)
+            return;
+        if (n < 12)
+            continue;
+
+        // Ответ принимается, только если ID, сокет (исходный порт) и сервер совпадают
+        // с текущей попыткой запроса
+        uint32_t slot = slotById[static_cast<uint16_t>(buf[0] << 8 | buf[1])];
+        if (slot == kNoSlot || !(buf[2] & 0x80))
+            continue;
+        const Pending& q = pending[slot];
+        const sockaddr_in& server = servers[q.server];
+        if (!q.busy || q.socket != socket || server.sin_addr.s_addr != from.sin_addr.s_addr ||
+            server.sin_port != from.sin_port)
+            continue;
+
+        const size_t len = static_cast<size_t>(n);
+        unsigned rcode   = buf[3] & 0x0F;
+        unsigned qdcount = static_cast<unsigned>(buf[4] << 8 | buf[5]);
+        unsigned ancount = static_cast<unsigned>(buf[6] << 8 | buf[7]);
+
+        // Вопрос в ответе должен совпадать с тем, что мы спрашивали
+        std::string qname;
+        size_t pos = qdcount ? readName(buf, len, 12, &qname) : 0;
+        std::string expected = q.host;
+        std::transform(expected.begin(), expected.end(), expected.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (!expected.empty() && expected.back() == '.')
+            expected.pop_back();
+        if (!pos || qname != expected || pos + 4 > len)
+            continue;
+        pos += 4;
+
+        if (rcode == 3) {
+            complete(static_cast<uint16_t>(slot), std::string(), true);
+            continue;
+        }
+
+        std::string address;
+        for (unsigned i = 0; rcode == 0 && i < ancount && address.empty(); ++i) {
+            pos = readName(buf, len, pos, nullptr);
+            if (!pos || pos + 10 > len)
+                break;
+            unsigned type  = static_cast<unsigned>(buf[pos] << 8 | buf[pos + 1]);
+            unsigned klass = static_cast<unsigned>(buf[pos + 2] << 8 | buf[pos + 3]);
+            size_t rdlen   = static_cast<size_t>(buf[pos + 8] << 8 | buf[pos + 9]);
+            pos += 10;
+            if (pos + rdlen > len)
+                break;
+            if (type == 1 && klass == 1 && rdlen == 4) {
+                char text[INET_ADDRSTRLEN];
+                if (inet_ntop(AF_INET, buf + pos, text, sizeof(text)))
+                    address = text;
+            }
+            pos += rdlen;
+        }
+        // SERVFAIL, пустой ответ и т.п. — пусть curl попробует сам
+        complete(static_cast<uint16_t>(slot), address, false);
+    }
+}
+
+void DnsResolver::expire() {
+    auto now = std::chrono::steady_clock::now();
+    while (!deadlines.empty() && deadlines.front().at <= now) {
+        Deadline d = deadlines.front();
+        deadlines.pop_front();
+        Pending& p = pending[d.slot];
+        if (!p.busy || p.generation != d.generation)
+            continue;
+        if (p.attempts < kMaxAttempts && sendQuery(d.slot))
+            continue;
+        complete(d.slot, std::string(), false);
+    }
+}
+
+void DnsResolver::run() {
+    const bool usable = sockets.front().fd >= 0 && !servers.empty();
+    std::vector<pollfd> fds(sockets.size());
+    while (true) {
+        // Набираем новые запросы, пока есть свободные слоты
+        bool exhausted = false;
+        while (inFlight < maxInFlight) {
+            std::string domain;
+            if (inFlight == 0) {
+                if (!input.pop(domain)) {
+                    exhausted = true;
+                    break;
+                }
+            } else if (!input.tryPop(domain)) {
+                exhausted = input.isClosed() && input.sizeApprox() == 0;
+                break;
+            }
+            domain.erase(std::remove(domain.begin(), domain.end(), '\r'), domain.end());
+            domain.erase(std::remove(domain.begin(), domain.end(), '\n'), domain.end());
+            if (domain.empty())
+                continue;
+
+            std::string host;
+            int port = 0;
+            splitHostPort(domain, host, port);
+            in_addr literal;
+            // IP-адреса и имена без точки (localhost и т.п.) не резолвим
+            if (!usable || host.find('.') == std::string::npos || inet_pton(AF_INET, host.c_str(), &literal) == 1) {
+                taskSink(DomainTask{std::move(domain), std::string()});
+                continue;
+            }
+
+            uint16_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            Pending& p = pending[slot];
+            p.task = DomainTask{std::move(domain), std::string()};
+            p.host = std::move(host);
+            p.attempts = 0;
+            p.busy = true;
+            ++inFlight;
+            if (!sendQuery(slot))
+                complete(slot, std::string(), false);
+        }
+
+        if (inFlight == 0) {
+            if (exhausted)
+                break;
+            continue;
+        }
+
+        // Ждём ответы; если входная очередь ещё может пополниться — просыпаемся чаще
+        int timeoutMs = 100;
+        if (!deadlines.empty()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadlines.front().at - std::chrono::steady_clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<long long>(0, std::min<long long>(left, timeoutMs)));
+        }
+        if (!exhausted && inFlight < maxInFlight)
+            timeoutMs = std::min(timeoutMs, 20);
+
+        for (size_t i = 0; i < sockets.size(); ++i)
+            fds[i] = pollfd{sockets[i].fd, POLLIN, 0};
+        if (::poll(fds.data(), fds.size(), timeoutMs) > 0) {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (fds[i].revents)
+                    receive(static_cast<uint16_t>(i));
+            }
+        }
+        expire();
+    }
+
+    Logger::info("DnsResolver: разрешено %zu, NXDOMAIN %zu, без ответа %zu",
+                 resolved.load(), nxdomain.load(), unresolved.load());
+    doneSink();
+}
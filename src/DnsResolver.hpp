@@ -0,0 +1,108 @@
+// src/DnsResolver.hpp
+#ifndef DNSRESOLVER_HPP
+#define DNSRESOLVER_HPP
+
+#include "DomainTask.hpp"
+#include "BoundedQueue.hpp"
+#include <netinet/in.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Стадия предварительного разрешения имён между DomainLoader и Worker.
+// Один поток держит до maxInFlight одновременных UDP-запросов (тип A) к заданным
+// DNS-серверам, не дожидаясь ответа на каждый. Домены с NXDOMAIN не занимают слоты
+// загрузки: воркер сразу пишет для них результат с CURLE_COULDNT_RESOLVE_HOST; найденный
+// адрес передаётся в Worker и попадает в curl через CURLOPT_RESOLVE. При таймауте/SERVFAIL
+// домен уходит дальше без адреса.
+// Против подделки ответов: случайный DNS ID на каждую попытку и несколько UDP-сокетов,
+// пересоздаваемых с новым исходным портом; ответ принимается только от того сервера
+// и на тот сокет, куда ушла текущая попытка.
+class DnsResolver {
+public:
+    // Куда отдаются задачи; по умолчанию — Worker::enqueueTask / Worker::notifyFinished
+    using TaskSink = std::function<void(DomainTask&& task)>;
+    using DoneSink = std::function<void()>;
+
+    // servers: "ip" или "ip:port"; пустой список — серверы из /etc/resolv.conf
+    DnsResolver(const std::vector<std::string>& servers, size_t maxInFlight);
+    ~DnsResolver();
+
+    // Вызывается до start(), например чтобы направить задачи в HostScheduler
+    void setSink(TaskSink onTask, DoneSink onDone);
+    // Куда отдаются задачи с NXDOMAIN (unresolvable); по умолчанию — прямо в очередь
+    // воркеров, мимо HostScheduler: к хосту никто не обращается, квота не нужна
+    void setUnresolvableSink(TaskSink onTask) { unresolvableSink = std::move(onTask); }
+
+    void start();
+    void join();
+
+    // Вызываются из DomainLoader
+    void enqueue(const std::string& domain);
+    void notifyFinished();
+
+private:
+    struct Pending {
+        DomainTask task;
+        std::string host;
+        uint16_t generation = 0;
+        uint16_t queryId = 0;  // DNS ID текущей попытки
+        uint16_t socket = 0;   // сокет (исходный порт) текущей попытки
+        uint16_t server = 0;   // сервер текущей попытки
+        int attempts = 0;
+        bool busy = false;
+        bool mapped = false;   // queryId занят в slotById
+    };
+    struct Deadline {
+        uint16_t slot;
+        uint16_t generation;
+        std::chrono::steady_clock::time_point at;
+    };
+    // UDP-сокет со своим исходным портом; после kQueriesPerPort запросов пересоздаётся
+    struct Socket {
+        int fd = -1;
+        size_t sent = 0;
+        size_t outstanding = 0;
+    };
+
+    void run();
+    bool sendQuery(uint16_t slot);
+    void releaseQuery(Pending& p);
+    void receive(uint16_t socket);
+    void expire();
+    void complete(uint16_t slot, const std::string& address, bool drop);
+    bool openSocket(Socket& s);
+
+    std::vector<sockaddr_in> servers;
+    size_t maxInFlight;
+    std::vector<Socket> sockets;
+    std::mt19937 random;
+
+    TaskSink taskSink;
+    TaskSink unresolvableSink;
+    DoneSink doneSink;
+
+    std::thread resolverThread;
+    BoundedQueue<std::string> input;
+
+    // Таблица ожидающих ответа запросов (слоты); DNS ID случайный для каждой попытки
+    // и отображается на слот через slotById, чтобы подделать ответ вслепую было трудно
+    std::vector<Pending> pending;
+    std::vector<uint16_t> freeSlots;
+    std::vector<uint32_t> slotById;
+    std::deque<Deadline> deadlines;
+    size_t inFlight = 0;
+
+    // Статистика
+    std::atomic<size_t> resolved{0};
+    std::atomic<size_t> nxdomain{0};
+    std::atomic<size_t> unresolved{0};
+};
+
+#endif // DNSRESOLVER_HPP
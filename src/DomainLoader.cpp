@@ -2,13 +2,23 @@
 #include "DomainLoader.hpp"
 #include "Worker.hpp"
 #include "Logger.hpp"
+#include "Journal.hpp"
+#include "RangeCoordinator.hpp"
+#include "Sharding.hpp"
 #include <fstream>
 #include <string>
 
 DomainLoader::DomainLoader(const std::string& fn)
     : filename(fn)
+    , lineSink(&Worker::enqueueDomain)
+    , doneSink(&Worker::notifyFinished)
 {}
 
+void DomainLoader::setSink(LineSink onLine, DoneSink onDone) {
+    lineSink = std::move(onLine);
+    doneSink = std::move(onDone);
+}
+
 DomainLoader::~DomainLoader() {}
 
 void DomainLoader::start() {
@@ -21,16 +31,69 @@ void DomainLoader::join() {
 }
 
 void DomainLoader::run() {
+    if (coordinator.empty())
+        readFile();
+    else
+        pull();
+    if (normalizer)
+        normalizer->report();
+    if (Sharding::enabled()) {
+        Sharding::addSkipped(foreign);
+        Logger::info("Шард %zu/%zu: строк других узлов пропущено %zu",
+                     Sharding::shardIndex(), Sharding::shardCount(), foreign);
+    }
+    doneSink();
+}
+
+void DomainLoader::readFile() {
     std::ifstream in(filename);
     if (!in) {
         Logger::error("Failed to open domain file: %s", filename.c_str());
-        Worker::notifyFinished();
         return;
     }
     std::string line;
-    while (std::getline(in, line)) {
-        if (!line.empty())
-            Worker::enqueueDomain(line);
+    while (std::getline(in, line))
+        handle(line);
+}
+
+// Кусок берётся, когда предыдущий разошёлся по очереди: медленный узел просит реже
+void DomainLoader::pull() {
+    RangeCoordinator::Client client;
+    if (!client.connect(coordinator))
+        return;
+    std::string chunk, line;
+    size_t chunks = 0;
+    while (client.next(chunk)) {
+        ++chunks;
+        size_t pos = 0;
+        while (pos < chunk.size()) {
+            size_t end = chunk.find('\n', pos);
+            if (end == std::string::npos)
+                end = chunk.size();
+            line.assign(chunk, pos, end - pos);
+            handle(line);
+            pos = end + 1;
+        }
     }
-    Worker::notifyFinished();
+    Logger::info("Получено кусков входа от координатора %s: %zu", coordinator.c_str(), chunks);
+}
+
+void DomainLoader::handle(std::string& line) {
+    if (normalizer) {
+        if (!normalizer->normalize(line, normalized))
+            return;
+        line.swap(normalized);
+    }
+    if (line.empty())
+        return;
+    if (!Sharding::owns(line)) {
+        ++foreign;
+        return;
+    }
+    // Домены, завершённые в прерванном прогоне (--resume), отсекаются до DNS и очереди
+    if (Journal::isDone(line))
+        return;
+    if (normalizer && !normalizer->firstSeen(line))
+        return;
+    lineSink(line);
 }
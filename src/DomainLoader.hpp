@@ -2,21 +2,44 @@
 #ifndef DOMAINLOADER_HPP
 #define DOMAINLOADER_HPP
 
+#include "DomainNormalizer.hpp"
+#include <functional>
 #include <string>
 #include <thread>
 
 class DomainLoader {
 public:
+    // Куда отдаются строки файла; по умолчанию — напрямую в очередь Worker
+    using LineSink = std::function<void(const std::string& line)>;
+    using DoneSink = std::function<void()>;
+
     DomainLoader(const std::string& filename);
     ~DomainLoader();
 
+    // Вызывается до start(), например чтобы направить домены в DnsResolver
+    void setSink(LineSink onLine, DoneSink onDone);
+    // Стадия нормализации и дедупликации (--dedup, --fold-www, --strip-paths); nullptr — без неё
+    void setNormalizer(DomainNormalizer* n) { normalizer = n; }
+    // Брать вход не из файла, а кусками у координатора (--pull=host:port, см. RangeCoordinator)
+    void setCoordinator(const std::string& address) { coordinator = address; }
+
     void start();
     void join();
 
 private:
     void run();
+    void readFile();
+    void pull();
+    // Нормализация, разбиение по узлам, журнал и дедупликация одной строки; затем lineSink
+    void handle(std::string& line);
     std::thread loaderThread;
     std::string filename;
+    LineSink    lineSink;
+    DoneSink    doneSink;
+    DomainNormalizer* normalizer = nullptr;
+    std::string coordinator;
+    std::string normalized;
+    size_t      foreign = 0; // строки других узлов (--shard)
 };
 
 #endif // DOMAINLOADER_HPP
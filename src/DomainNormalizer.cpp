@@ -0,0 +1,255 @@
+// src/DomainNormalizer.cpp
+#include "DomainNormalizer.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+
+namespace {
+
+// Строчная форма кодовой точки: ASCII, Latin-1, греческий и кириллица — этого
+// хватает для доменов в национальных зонах (полное отображение UTS #46 не делается)
+uint32_t lowerCodepoint(uint32_t cp) {
+    if (cp >= 'A' && cp <= 'Z')
+        return cp + 32;
+    if ((cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) || (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) ||
+        (cp >= 0x410 && cp <= 0x42F))
+        return cp + 32;
+    if (cp >= 0x400 && cp <= 0x40F)
+        return cp + 80;
+    return cp;
+}
+
+// Очередная кодовая точка UTF-8; false — некорректная последовательность
+bool decodeUtf8(std::string_view s, size_t& i, uint32_t& cp) {
+    unsigned char c = static_cast<unsigned char>(s[i]);
+    size_t len = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 0;
+    if (!len || i + len > s.size())
+        return false;
+    cp = len == 1 ? c : c & (0x7F >> len);
+    for (size_t k = 1; k < len; ++k) {
+        unsigned char cc = static_cast<unsigned char>(s[i + k]);
+        if ((cc & 0xC0) != 0x80)
+            return false;
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    i += len;
+    return cp <= 0x10FFFF && !(cp >= 0xD800 && cp <= 0xDFFF);
+}
+
+// Точки-разделители IDNA: ASCII, идеографическая и полноширинные
+bool isDot(uint32_t cp) {
+    return cp == '.' || cp == 0x3002 || cp == 0xFF0E || cp == 0xFF61;
+}
+
+bool isHostChar(uint32_t cp) {
+    return (cp >= 'a' && cp <= 'z') || (cp >= '0' && cp <= '9') || cp == '-' || cp == '_';
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+DomainNormalizer::DomainNormalizer(const Settings& s) : settings(s) {
+    if (settings.dedup == Dedup::Bloom)
+        bloom = std::make_unique<BloomFilter>(std::max<size_t>(settings.expected, 1u << 16),
+                                              settings.falsePositiveRate);
+}
+
+// RFC 3492, раздел 6.3
+bool DomainNormalizer::punycode(const std::vector<uint32_t>& label, std::string& out) {
+    constexpr uint32_t base = 36, tmin = 1, tmax = 26, skew = 38, damp = 700;
+    auto digit = [](uint32_t d) { return static_cast<char>(d < 26 ? 'a' + d : '0' + d - 26); };
+    auto adapt = [&](uint32_t delta, uint32_t points, bool first) {
+        delta = first ? delta / damp : delta / 2;
+        delta += delta / points;
+        uint32_t k = 0;
+        while (delta > ((base - tmin) * tmax) / 2) {
+            delta /= base - tmin;
+            k += base;
+        }
+        return k + (base - tmin + 1) * delta / (delta + skew);
+    };
+
+    size_t start = out.size();
+    for (uint32_t cp : label) {
+        if (cp < 0x80)
+            out.push_back(static_cast<char>(cp));
+    }
+    uint32_t basic = static_cast<uint32_t>(out.size() - start);
+    uint32_t handled = basic;
+    if (basic)
+        out.push_back('-');
+
+    uint32_t n = 0x80, delta = 0, bias = 72;
+    const uint32_t total = static_cast<uint32_t>(label.size());
+    while (handled < total) {
+        uint32_t m = UINT32_MAX;
+        for (uint32_t cp : label) {
+            if (cp >= n && cp < m)
+                m = cp;
+        }
+        if ((m - n) > (UINT32_MAX - delta) / (handled + 1))
+            return false;
+        delta += (m - n) * (handled + 1);
+        n = m;
+        for (uint32_t cp : label) {
+            if (cp < n && ++delta == 0)
+                return false;
+            if (cp != n)
+                continue;
+            uint32_t q = delta;
+            for (uint32_t k = base;; k += base) {
+                uint32_t t = k <= bias ? tmin : k >= bias + tmax ? tmax : k - bias;
+                if (q < t)
+                    break;
+                out.push_back(digit(t + (q - t) % (base - t)));
+                q = (q - t) / (base - t);
+            }
+            out.push_back(digit(q));
+            bias = adapt(delta, handled + 1, handled == basic);
+            delta = 0;
+            ++handled;
+        }
+        ++delta;
+        ++n;
+    }
+    return true;
+}
+
+// Имя хоста: метки в нижнем регистре, не-ASCII метки — в xn--punycode
+bool DomainNormalizer::normalizeHost(std::string_view host, std::string& out) {
+    bool idn = false;
+    size_t i = 0, labels = 0;
+    while (true) {
+        codepoints.clear();
+        bool ascii = true, dot = false;
+        // Метка до разделителя
+        while (i < host.size()) {
+            uint32_t cp;
+            if (!decodeUtf8(host, i, cp))
+                return false;
+            if (isDot(cp)) {
+                dot = true;
+                break;
+            }
+            cp = lowerCodepoint(cp);
+            if (cp < 0x80 && !isHostChar(cp))
+                return false;
+            ascii = ascii && cp < 0x80;
+            codepoints.push_back(cp);
+        }
+        if (codepoints.empty()) {
+            // Пустая метка допустима только после завершающей точки
+            if (dot || !labels)
+                return false;
+            out.pop_back();
+            break;
+        }
+        ++labels;
+        if (ascii) {
+            for (uint32_t cp : codepoints)
+                out.push_back(static_cast<char>(cp));
+        } else {
+            idn = true;
+            out += "xn--";
+            if (!punycode(codepoints, out))
+                return false;
+        }
+        if (!dot)
+            break;
+        out.push_back('.');
+    }
+    if (idn)
+        ++stats.idn;
+    return true;
+}
+
+bool DomainNormalizer::normalize(std::string_view line, std::string& out) {
+    ++stats.read;
+    out.clear();
+    while (!line.empty() && isSpace(line.front()))
+        line.remove_prefix(1);
+    while (!line.empty() && isSpace(line.back()))
+        line.remove_suffix(1);
+    if (line.empty()) {
+        ++stats.invalid;
+        return false;
+    }
+    std::string_view original = line;
+
+    // Схема
+    std::string_view scheme;
+    size_t sep = line.find("://");
+    if (sep != std::string_view::npos) {
+        scheme = line.substr(0, sep);
+        line.remove_prefix(sep + 3);
+        for (char c : scheme)
+            out.push_back(static_cast<char>(c >= 'A' && c <= 'Z' ? c + 32 : c));
+        out += "://";
+    }
+    // Порт по умолчанию убирается только при явной схеме: без неё порт влияет на выбор схемы (--scheme)
+    const char* defaultPort = out == "https://" ? "443" : out == "http://" ? "80" : nullptr;
+
+    // Хост, порт и остаток (путь, запрос, фрагмент)
+    size_t hostEnd = line.find_first_of("/?#");
+    std::string_view tail = hostEnd == std::string_view::npos ? std::string_view() : line.substr(hostEnd);
+    std::string_view host = line.substr(0, hostEnd);
+    std::string_view port;
+    size_t colon = host.rfind(':');
+    if (colon != std::string_view::npos) {
+        port = host.substr(colon + 1);
+        host = host.substr(0, colon);
+        if (port.empty() || port.size() > 5 || port.find_first_not_of("0123456789") != std::string_view::npos) {
+            ++stats.invalid;
+            return false;
+        }
+        while (port.size() > 1 && port.front() == '0')
+            port.remove_prefix(1);
+        if (defaultPort && port == defaultPort)
+            port = std::string_view();
+    }
+
+    size_t hostStart = out.size();
+    if (host.empty() || !normalizeHost(host, out)) {
+        ++stats.invalid;
+        return false;
+    }
+    // www. сворачивается, только если после него остаётся имя с точкой
+    if (settings.foldWww && out.compare(hostStart, 4, "www.") == 0 &&
+        out.find('.', hostStart + 4) != std::string::npos)
+        out.erase(hostStart, 4);
+    if (!port.empty())
+        out.append(":").append(port);
+    if (!settings.stripPaths && tail != "/")
+        out.append(tail.data(), tail.size());
+
+    if (out != original)
+        ++stats.changed;
+    return true;
+}
+
+bool DomainNormalizer::firstSeen(std::string_view normalized) {
+    bool first = true;
+    if (settings.dedup == Dedup::Exact)
+        first = exact.insert(FingerprintSet::fingerprint(normalized));
+    else if (settings.dedup == Dedup::Bloom)
+        first = bloom->insert(FingerprintSet::fingerprint(normalized));
+    if (!first)
+        ++stats.duplicates;
+    return first;
+}
+
+size_t DomainNormalizer::memoryBytes() const {
+    return bloom ? bloom->memoryBytes() : exact.memoryBytes();
+}
+
+void DomainNormalizer::report() const {
+    Logger::info("Нормализация входа: прочитано %llu, изменено %llu (IDN %llu), некорректных %llu, "
+                 "дубликатов удалено %llu (%.1f%%), память дедупликации %.1f МБ",
+                 static_cast<unsigned long long>(stats.read), static_cast<unsigned long long>(stats.changed),
+                 static_cast<unsigned long long>(stats.idn), static_cast<unsigned long long>(stats.invalid),
+                 static_cast<unsigned long long>(stats.duplicates),
+                 stats.read ? 100.0 * static_cast<double>(stats.duplicates) / static_cast<double>(stats.read) : 0.0,
+                 static_cast<double>(memoryBytes()) / (1024.0 * 1024.0));
+}
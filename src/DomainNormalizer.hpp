@@ -0,0 +1,66 @@
+// src/DomainNormalizer.hpp
+#ifndef DOMAINNORMALIZER_HPP
+#define DOMAINNORMALIZER_HPP
+
+#include "BloomFilter.hpp"
+#include "FingerprintSet.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Нормализация и дедупликация входных строк (стадия DomainLoader, один поток).
+// Приводит строку к каноническому виду: пробелы по краям убираются, схема и имя
+// хоста — в нижний регистр, IDN-метки — в punycode (xn--), завершающая точка,
+// порт по умолчанию явной схемы и одиночный "/" отбрасываются; по настройке — "www." и путь.
+// Повторы отсекаются по 64-битному отпечатку канонической строки: точное множество
+// (FingerprintSet, 11–22 байта на домен) или масштабируемый фильтр Блума (~3 байта
+// на домен при доле ложных срабатываний 1e-4; ложное срабатывание — пропущенный домен).
+class DomainNormalizer {
+public:
+    enum class Dedup { None, Exact, Bloom };
+
+    struct Settings {
+        bool   foldWww = false;     // www.example.com -> example.com
+        bool   stripPaths = false;  // example.com/path?q -> example.com
+        Dedup  dedup = Dedup::None;
+        double falsePositiveRate = 1e-4; // для Bloom
+        size_t expected = 0;        // оценка числа доменов (размер первого среза Bloom)
+    };
+
+    struct Counters {
+        uint64_t read = 0;
+        uint64_t invalid = 0;     // пустые строки и строки, не похожие на домен
+        uint64_t duplicates = 0;
+        uint64_t changed = 0;     // строки, изменённые нормализацией
+        uint64_t idn = 0;         // строки с IDN-метками
+    };
+
+    explicit DomainNormalizer(const Settings& settings);
+
+    // Канонический вид строки; false — строку нужно пропустить (некорректная)
+    bool normalize(std::string_view line, std::string& out);
+    // true — строка встречается впервые (без дедупликации — всегда)
+    bool firstSeen(std::string_view normalized);
+
+    const Counters& counters() const { return stats; }
+    size_t memoryBytes() const;
+    // Итог в лог
+    void report() const;
+
+    // Кодирование метки в punycode (RFC 3492) без префикса "xn--"
+    static bool punycode(const std::vector<uint32_t>& label, std::string& out);
+
+private:
+    bool normalizeHost(std::string_view host, std::string& out);
+
+    Settings                        settings;
+    Counters                        stats;
+    FingerprintSet                  exact;
+    std::unique_ptr<BloomFilter>    bloom;
+    std::vector<uint32_t>           codepoints; // рабочий буфер метки
+};
+
+#endif // DOMAINNORMALIZER_HPP
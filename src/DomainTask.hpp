@@ -0,0 +1,57 @@
+// src/DomainTask.hpp
+#ifndef DOMAINTASK_HPP
+#define DOMAINTASK_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+// Элемент конвейера DomainLoader -> [DnsResolver] -> Worker
+struct DomainTask {
+    std::string domain;   // строка из входного файла
+    std::string address;  // IPv4-адрес, найденный DnsResolver (пусто — резолвит curl)
+    uint64_t    ticket = 0; // квота HostScheduler, возвращается по завершении (0 — без планировщика)
+    bool        unresolvable = false; // NXDOMAIN от DnsResolver: запроса не будет, воркер только пишет результат
+};
+
+// Выделяет имя хоста и порт из строки входного файла
+// ("example.com", "example.com:8080/path", "https://example.com/"). port = 0 — порт не указан.
+inline void splitHostPort(std::string_view domain, std::string& host, int& port) {
+    size_t begin = domain.find("://");
+    begin = (begin == std::string_view::npos) ? 0 : begin + 3;
+    size_t end = domain.find_first_of("/?#", begin);
+    if (end == std::string_view::npos)
+        end = domain.size();
+    host.assign(domain.data() + begin, end - begin);
+    port = 0;
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(':') == colon) {
+        port = std::atoi(host.c_str() + colon + 1);
+        host.erase(colon);
+    }
+}
+
+// Регистрируемый домен хоста (приближённо, без Public Suffix List): последние две
+// метки, или три, если предпоследняя — типичный домен второго уровня под
+// национальной зоной ("example.co.uk", "shop.com.ru"). IP-адреса возвращаются как есть.
+inline std::string_view registrableDomain(std::string_view host) {
+    while (!host.empty() && host.back() == '.')
+        host.remove_suffix(1);
+    size_t last = host.rfind('.');
+    if (last == std::string_view::npos || host.find_first_not_of("0123456789.") == std::string_view::npos)
+        return host;
+    size_t second = last ? host.rfind('.', last - 1) : std::string_view::npos;
+    if (second == std::string_view::npos)
+        return host;
+    std::string_view sld = host.substr(second + 1, last - second - 1);
+    bool ccTld = host.size() - last - 1 == 2;
+    if (ccTld && (sld == "co" || sld == "com" || sld == "net" || sld == "org" || sld == "gov" ||
+                  sld == "edu" || sld == "ac" || sld == "or" || sld == "ne" || sld == "msk" || sld == "spb")) {
+        size_t third = second ? host.rfind('.', second - 1) : std::string_view::npos;
+        return third == std::string_view::npos ? host : host.substr(third + 1);
+    }
+    return host.substr(second + 1);
+}
+
+#endif // DOMAINTASK_HPP
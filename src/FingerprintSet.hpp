@@ -0,0 +1,86 @@
+// src/FingerprintSet.hpp
+#ifndef FINGERPRINTSET_HPP
+#define FINGERPRINTSET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Компактное множество 64-битных отпечатков строк: открытая адресация с линейным
+// пробированием, 8 байт на ячейку, заполнение не выше 3/4. Отпечаток 0 зарезервирован
+// под пустую ячейку — fingerprint() его никогда не возвращает.
+class FingerprintSet {
+public:
+    // FNV-1a с финальным перемешиванием (splitmix64)
+    static uint64_t fingerprint(std::string_view s) {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27; h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return h ? h : 1;
+    }
+
+    // Готовит таблицу под n элементов без перестроений
+    void reserve(size_t n) {
+        size_t cap = 16;
+        while (cap * 3 < n * 4)
+            cap <<= 1;
+        if (cap > slots.size())
+            rehash(cap);
+    }
+
+    // true — отпечаток добавлен впервые
+    bool insert(uint64_t fp) {
+        if ((count + 1) * 4 > slots.size() * 3)
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        size_t i = fp & mask;
+        while (slots[i]) {
+            if (slots[i] == fp)
+                return false;
+            i = (i + 1) & mask;
+        }
+        slots[i] = fp;
+        ++count;
+        return true;
+    }
+
+    bool contains(uint64_t fp) const {
+        if (!count)
+            return false;
+        size_t i = fp & mask;
+        while (slots[i]) {
+            if (slots[i] == fp)
+                return true;
+            i = (i + 1) & mask;
+        }
+        return false;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t memoryBytes() const { return slots.size() * sizeof(uint64_t); }
+
+private:
+    void rehash(size_t cap) {
+        std::vector<uint64_t> old;
+        old.swap(slots);
+        slots.assign(cap, 0);
+        mask = cap - 1;
+        count = 0;
+        for (uint64_t fp : old) {
+            if (fp)
+                insert(fp);
+        }
+    }
+
+    std::vector<uint64_t> slots;
+    size_t mask = 0;
+    size_t count = 0;
+};
+
+#endif // FINGERPRINTSET_HPP
@@ -0,0 +1,320 @@
+// src/HostScheduler.cpp
+#include "HostScheduler.hpp"
+#include "Worker.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Шаг колеса таймеров и пауза цикла, когда делать нечего
+constexpr uint64_t kTickMs = 10;
+// Как часто чистить таблицу ключей от простаивающих
+constexpr uint64_t kCollectMs = 1000;
+constexpr size_t   kInputBulk = 256;
+}
+
+HostScheduler::HostScheduler(const Limits& limits_, size_t maxBacklog_)
+    : limits(limits_)
+    , maxBacklog(std::max<size_t>(maxBacklog_, 1))
+    , taskSink([](DomainTask&& task) { return Worker::tryEnqueueTask(std::move(task)); })
+    , doneSink(&Worker::notifyFinished)
+    , input(65536)
+    , epoch(std::chrono::steady_clock::now())
+{}
+
+HostScheduler::~HostScheduler() {
+    join();
+}
+
+void HostScheduler::setSink(TaskSink onTask, DoneSink onDone) {
+    taskSink = std::move(onTask);
+    doneSink = std::move(onDone);
+}
+
+void HostScheduler::start() {
+    schedulerThread = std::thread(&HostScheduler::run, this);
+}
+
+void HostScheduler::join() {
+    if (schedulerThread.joinable())
+        schedulerThread.join();
+}
+
+void HostScheduler::enqueue(const std::string& domain) {
+    input.push(DomainTask{domain, std::string()});
+}
+
+void HostScheduler::enqueueTask(DomainTask&& task) {
+    input.push(std::move(task));
+}
+
+void HostScheduler::notifyFinished() {
+    input.close();
+}
+
+void HostScheduler::release(uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(releaseMutex);
+    releases.push_back(ticket);
+}
+
+uint64_t HostScheduler::nowMs() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+uint32_t HostScheduler::keyFor(std::string_view name, bool isIp, uint64_t now) {
+    std::string keyName(isIp ? "ip:" : "");
+    keyName.append(name.data(), name.size());
+    auto it = keyIndex.find(keyName);
+    if (it != keyIndex.end())
+        return it->second;
+
+    uint32_t idx;
+    if (!freeKeys.empty()) {
+        idx = freeKeys.back();
+        freeKeys.pop_back();
+        keys[idx] = Key();
+    } else {
+        idx = static_cast<uint32_t>(keys.size());
+        keys.emplace_back();
+    }
+    Key& k = keys[idx];
+    k.isIp = isIp;
+    k.tokens = std::max(1.0, rateOf(k)); // новый ключ начинает с полным ведром
+    k.refilledMs = now;
+    k.name = keyName;
+    keyIndex.emplace(std::move(keyName), idx);
+    return idx;
+}
+
+void HostScheduler::admit(DomainTask&& task, uint64_t now) {
+    task.domain.erase(std::remove(task.domain.begin(), task.domain.end(), '\r'), task.domain.end());
+    task.domain.erase(std::remove(task.domain.begin(), task.domain.end(), '\n'), task.domain.end());
+    if (task.domain.empty())
+        return;
+
+    std::string host;
+    int port = 0;
+    splitHostPort(task.domain, host, port);
+    uint32_t hostKey = keyFor(registrableDomain(host), false, now);
+    uint32_t primary = hostKey;
+    uint32_t secondary = kNone;
+    if (!task.address.empty()) {
+        primary = keyFor(task.address, true, now);
+        secondary = hostKey;
+        ++keys[secondary].refs;
+    }
+
+    uint32_t n;
+    if (!freeNodes.empty()) {
+        n = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        n = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[n].task = std::move(task);
+    nodes[n].secondary = secondary;
+    nodes[n].next = kNone;
+
+    Key& k = keys[primary];
+    if (k.tail == kNone)
+        k.head = n;
+    else
+        nodes[k.tail].next = n;
+    k.tail = n;
+    ++backlog;
+    if (k.state == KeyState::Idle)
+        makeReady(primary);
+}
+
+void HostScheduler::makeReady(uint32_t idx) {
+    keys[idx].state = KeyState::Ready;
+    ready.push_back(idx);
+}
+
+void HostScheduler::wait(uint32_t idx, uint64_t dueMs) {
+    keys[idx].state = KeyState::Waiting;
+    wheel.schedule((dueMs + kTickMs - 1) / kTickMs, idx);
+    throttled.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool HostScheduler::hasToken(Key& k, uint64_t now, uint64_t& dueMs) {
+    double rate = rateOf(k);
+    if (rate <= 0)
+        return true;
+    k.tokens = std::min(std::max(1.0, rate), k.tokens + static_cast<double>(now - k.refilledMs) * rate / 1000.0);
+    k.refilledMs = now;
+    if (k.tokens >= 1.0)
+        return true;
+    dueMs = now + static_cast<uint64_t>(std::ceil((1.0 - k.tokens) * 1000.0 / rate));
+    return false;
+}
+
+// Лимит соединений или токенов исчерпан; dueMs — когда проверить снова (0 — ждать release)
+bool HostScheduler::overLimit(Key& k, uint64_t now, uint64_t& dueMs) {
+    size_t conns = connsOf(k);
+    if (conns && k.inFlight >= conns) {
+        dueMs = 0;
+        return true;
+    }
+    return !hasToken(k, now, dueMs);
+}
+
+// Возвращает false, если получатель переполнен
+bool HostScheduler::dispatch(uint64_t now) {
+    while (!ready.empty()) {
+        uint32_t idx = ready.front();
+        ready.pop_front();
+        Key& k = keys[idx];
+        if (k.head == kNone) {
+            k.state = KeyState::Idle;
+            continue;
+        }
+
+        uint64_t dueMs = 0;
+        if (overLimit(k, now, dueMs)) {
+            if (dueMs) {
+                wait(idx, dueMs);
+            } else {
+                k.state = KeyState::Blocked; // вернётся в круг по release()
+                throttled.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        Node& n = nodes[k.head];
+        uint32_t s = n.secondary;
+        if (s != kNone && overLimit(keys[s], now, dueMs)) {
+            // Лимит домена у задачи, сгруппированной по IP: проверяем снова через тик
+            wait(idx, dueMs ? dueMs : now + kTickMs);
+            continue;
+        }
+
+        n.task.ticket = (static_cast<uint64_t>(idx) + 1) |
+                        (s == kNone ? 0 : (static_cast<uint64_t>(s) + 1) << 32);
+        if (!taskSink(std::move(n.task))) {
+            ready.push_front(idx);
+            return false;
+        }
+
+        ++k.inFlight;
+        if (rateOf(k) > 0)
+            k.tokens -= 1.0;
+        if (s != kNone) {
+            Key& sk = keys[s];
+            ++sk.inFlight;
+            --sk.refs;
+            if (rateOf(sk) > 0)
+                sk.tokens -= 1.0;
+        }
+        uint32_t head = k.head;
+        k.head = nodes[head].next;
+        if (k.head == kNone)
+            k.tail = kNone;
+        nodes[head].task = DomainTask();
+        freeNodes.push_back(head);
+        --backlog;
+        dispatched.fetch_add(1, std::memory_order_relaxed);
+
+        // Один запрос за ход: ключ уходит в конец круга
+        if (k.head != kNone)
+            ready.push_back(idx);
+        else
+            k.state = KeyState::Idle;
+    }
+    return true;
+}
+
+void HostScheduler::finish(uint32_t idx) {
+    Key& k = keys[idx];
+    if (k.inFlight)
+        --k.inFlight;
+    if (k.state == KeyState::Blocked) {
+        if (k.head != kNone)
+            makeReady(idx);
+        else
+            k.state = KeyState::Idle;
+    }
+    if (k.head == kNone && k.inFlight == 0)
+        idleKeys.push_back(idx);
+}
+
+void HostScheduler::applyReleases() {
+    {
+        std::lock_guard<std::mutex> lock(releaseMutex);
+        releasesTaken.swap(releases);
+    }
+    for (uint64_t ticket : releasesTaken) {
+        uint32_t p = static_cast<uint32_t>(ticket);
+        uint32_t s = static_cast<uint32_t>(ticket >> 32);
+        if (p)
+            finish(p - 1);
+        if (s)
+            finish(s - 1);
+    }
+    releasesTaken.clear();
+}
+
+// Удаляет из таблицы ключи без очереди и передач, чьё ведро уже наполнилось
+void HostScheduler::collectIdle(uint64_t now) {
+    std::vector<uint32_t> keep;
+    for (uint32_t idx : idleKeys) {
+        Key& k = keys[idx];
+        if (k.name.empty() || k.head != kNone || k.inFlight || k.refs)
+            continue;
+        double rate = rateOf(k);
+        if (rate > 0 && k.tokens + static_cast<double>(now - k.refilledMs) * rate / 1000.0 < std::max(1.0, rate)) {
+            keep.push_back(idx);
+            continue;
+        }
+        keyIndex.erase(k.name);
+        k.name.clear();
+        k.name.shrink_to_fit();
+        freeKeys.push_back(idx);
+    }
+    idleKeys.swap(keep);
+}
+
+void HostScheduler::run() {
+    std::vector<DomainTask> bulk(kInputBulk);
+    uint64_t lastCollect = 0;
+    auto fire = [this](uint32_t idx) {
+        if (keys[idx].state == KeyState::Waiting)
+            makeReady(idx);
+    };
+
+    while (true) {
+        uint64_t now = nowMs();
+        bool closed = input.isClosed();
+
+        size_t admitted = 0;
+        while (backlog < maxBacklog) {
+            size_t n = input.tryPopBulk(bulk.data(), std::min(kInputBulk, maxBacklog - backlog));
+            for (size_t i = 0; i < n; ++i)
+                admit(std::move(bulk[i]), now);
+            admitted += n;
+            if (n == 0)
+                break;
+        }
+
+        applyReleases();
+        wheel.advance(now / kTickMs, fire);
+        size_t before = dispatched.load(std::memory_order_relaxed);
+        bool sinkFull = !dispatch(now);
+        bool progress = admitted || dispatched.load(std::memory_order_relaxed) != before;
+
+        if (now - lastCollect >= kCollectMs) {
+            collectIdle(now);
+            lastCollect = now;
+        }
+
+        if (closed && backlog == 0 && input.sizeApprox() == 0 && !admitted)
+            break;
+        if (!progress || sinkFull)
+            std::this_thread::sleep_for(std::chrono::milliseconds(kTickMs));
+    }
+
+    Logger::info("HostScheduler: передано %zu, задержано лимитами %zu раз, ключей в таблице %zu",
+                 dispatched.load(), throttled.load(), keyIndex.size());
+    doneSink();
+}
@@ -0,0 +1,126 @@
+// src/HostScheduler.hpp
+#ifndef HOSTSCHEDULER_HPP
+#define HOSTSCHEDULER_HPP
+
+#include "DomainTask.hpp"
+#include "BoundedQueue.hpp"
+#include "TimerWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Стадия вежливости между [DnsResolver] и Worker. Ожидающие домены группируются
+// по ключу: IP-адресу (если его нашёл DnsResolver) или регистрируемому домену.
+// Для каждого ключа действуют лимиты одновременных соединений и запросов в секунду
+// (token bucket); запрос с IP дополнительно проверяется по лимитам своего домена.
+// Готовые ключи обходятся по кругу — по одному запросу за ход, ключи без токенов
+// ждут в колесе таймеров. Воркеры возвращают квоту через release() по завершении.
+class HostScheduler {
+public:
+    // 0 — ограничение отключено
+    struct Limits {
+        size_t hostConns = 0;
+        double hostRps = 0;
+        size_t ipConns = 0;
+        double ipRps = 0;
+    };
+
+    // Выдача задачи дальше без блокировки: false — получатель переполнен
+    using TaskSink = std::function<bool(DomainTask&& task)>;
+    using DoneSink = std::function<void()>;
+
+    // maxBacklog — сколько доменов держать в ожидании, прежде чем тормозить вход
+    HostScheduler(const Limits& limits, size_t maxBacklog);
+    ~HostScheduler();
+
+    // По умолчанию — Worker::tryEnqueueTask / Worker::notifyFinished
+    void setSink(TaskSink onTask, DoneSink onDone);
+
+    void start();
+    void join();
+
+    // Вызываются предыдущей стадией (DomainLoader или DnsResolver)
+    void enqueue(const std::string& domain);
+    void enqueueTask(DomainTask&& task);
+    void notifyFinished();
+
+    // Вызывается воркером по завершении передачи с ticket из задачи
+    void release(uint64_t ticket);
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    enum class KeyState : uint8_t { Idle, Ready, Waiting, Blocked };
+
+    struct Key {
+        std::string name;
+        bool        isIp = false;
+        KeyState    state = KeyState::Idle;
+        uint32_t    inFlight = 0;
+        uint32_t    refs = 0;          // ожидающие задачи других ключей, ссылающиеся на этот
+        uint32_t    head = kNone;      // очередь ожидающих задач (список узлов)
+        uint32_t    tail = kNone;
+        double      tokens = 0;
+        uint64_t    refilledMs = 0;
+    };
+
+    struct Node {
+        DomainTask task;
+        uint32_t   secondary = kNone;  // ключ домена для задач, сгруппированных по IP
+        uint32_t   next = kNone;
+    };
+
+    void run();
+    void admit(DomainTask&& task, uint64_t now);
+    uint32_t keyFor(std::string_view name, bool isIp, uint64_t now);
+    void applyReleases();
+    bool dispatch(uint64_t now);
+    void collectIdle(uint64_t now);
+
+    bool hasToken(Key& k, uint64_t now, uint64_t& dueMs);
+    double rateOf(const Key& k) const { return k.isIp ? limits.ipRps : limits.hostRps; }
+    size_t connsOf(const Key& k) const { return k.isIp ? limits.ipConns : limits.hostConns; }
+    uint64_t nowMs() const;
+    void makeReady(uint32_t idx);
+    void wait(uint32_t idx, uint64_t dueMs);
+    bool overLimit(Key& k, uint64_t now, uint64_t& dueMs);
+    void finish(uint32_t idx);
+
+    Limits limits;
+    size_t maxBacklog;
+    TaskSink taskSink;
+    DoneSink doneSink;
+
+    std::thread schedulerThread;
+    BoundedQueue<DomainTask> input;
+    std::chrono::steady_clock::time_point epoch;
+
+    // Состояние ниже принадлежит потоку планировщика
+    std::vector<Key> keys;
+    std::vector<uint32_t> freeKeys;
+    std::unordered_map<std::string, uint32_t> keyIndex;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    std::deque<uint32_t> ready;        // круговой обход готовых ключей
+    TimerWheel<uint32_t> wheel;        // ключи, ждущие токен
+    std::vector<uint32_t> idleKeys;    // кандидаты на удаление из таблицы
+    size_t backlog = 0;
+
+    // Возвраты квоты от воркеров
+    std::mutex releaseMutex;
+    std::vector<uint64_t> releases;
+    std::vector<uint64_t> releasesTaken;
+
+    // Статистика
+    std::atomic<size_t> dispatched{0};
+    std::atomic<size_t> throttled{0};
+};
+
+#endif // HOSTSCHEDULER_HPP
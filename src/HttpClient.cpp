@@ -1,26 +1,90 @@
 #include "HttpClient.hpp"
+#include "MemoryBudget.hpp"
+#include "Logger.hpp"
 #include <curl/curl.h>
 #include <vector>
 #include <string>
-#include <iostream>
 #include <thread>
 #include <chrono>
+#include <string_view>
 
-// Конструктор и деструктор: инициализация/очистка libcurl (глобально)
-HttpClient::HttpClient() {
-    curl_global_init(CURL_GLOBAL_ALL);
+namespace {
+// Сколько памяти буфер слота может удерживать между передачами
+constexpr size_t kRetainBytes = 64 * 1024;
+
+void trim(std::string& s) {
+    if (s.capacity() > kRetainBytes)
+        std::string().swap(s);
+    else
+        s.clear();
+}
 }
 
-HttpClient::~HttpClient() {
-    curl_global_cleanup();
+void HttpResponse::recycle() {
+    dropBuffered();
+    url.clear();
+    trim(headers);
+    trim(body);
+    code = 0;
+    bodySize = 0;
+    result = CURLE_OK;
+    effectiveUrl.clear();
+    bytesReceived = 0;
+    timings = TransferTimings();
+    ticket = 0;
+    retries = 0;
+    evicted = Eviction::None;
+    progressBytes = 0;
+    matcher = nullptr;
+    rules = nullptr;
+    ruleCache = nullptr;
+    aborted = false;
+    maxBytes = 0;
+    truncated = false;
+    fellBack = false;
+    interim = false;
+}
+
+void HttpResponse::dropBuffered() {
+    MemoryBudget::release(buffered);
+    buffered = 0;
 }
 
 // Callback для записи данных тела ответа
 size_t HttpClient::writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata) {
     size_t total = size * nmemb;
     HttpResponse *resp = static_cast<HttpResponse*>(userdata);
-    // Дописываем полученные данные в буфер тела ответа
-    resp->body.append(ptr, total);
+    resp->progressBytes += total;
+    // Бюджет тела: принимаем ровно до предела, затем прерываем передачу
+    size_t take = total;
+    bool overBudget = resp->maxBytes && resp->bodySize + total > resp->maxBytes;
+    if (overBudget)
+        take = resp->maxBytes - resp->bodySize;
+    resp->bodySize += take;
+    if (resp->matcher || resp->rules) {
+        // Потоковый режим: кусок сразу уходит в автоматы, тело не сохраняем.
+        // Как только все слова найдены и все правила решены, прерываем передачу
+        // (curl вернёт CURLE_WRITE_ERROR). Пустой список слов ничего не решает:
+        // без правил такая передача идёт до конца или до бюджета
+        bool words = resp->matcher && !resp->matcher->words().empty();
+        bool decided = (words || resp->rules) && (!words || resp->matcher->feed(resp->matchState, ptr, take));
+        if (resp->rules && !resp->rules->feedBody(resp->ruleState, *resp->ruleCache, ptr, take))
+            decided = false;
+        if (decided) {
+            resp->aborted = true;
+            return 0;
+        }
+    } else {
+        // Дописываем полученные данные в буфер тела ответа
+        resp->body.append(ptr, take);
+        resp->buffered += take;
+        MemoryBudget::acquire(take);
+    }
+    if (overBudget) {
+        resp->aborted = true;
+        resp->truncated = true;
+        return 0;
+    }
     return total;
 }
 
@@ -28,146 +92,59 @@ size_t HttpClient::writeCallback(char *ptr, size_t size, size_t nmemb, void *use
 size_t HttpClient::headerCallback(char *ptr, size_t size, size_t nmemb, void *userdata) {
     size_t total = size * nmemb;
     HttpResponse *resp = static_cast<HttpResponse*>(userdata);
-    std::string headerLine(ptr, total);
+    resp->progressBytes += total;
+    std::string_view headerLine(ptr, total);
     // Проверяем начало новой HTTP-ответа (статусная строка).
-    if (headerLine.rfind("HTTP/", 0) == 0) {
-        // Если это промежуточный статус 100 Continue – пропускаем его
-        if (headerLine.find("100 Continue") != std::string::npos) {
-            return total;
+    if (headerLine.substr(0, 5) == "HTTP/") {
+        long code = 0;
+        size_t i = headerLine.find(' ');
+        if (i != std::string_view::npos) {
+            for (++i; i < headerLine.size() && headerLine[i] >= '0' && headerLine[i] <= '9'; ++i)
+                code = code * 10 + (headerLine[i] - '0');
         }
+        // Промежуточный ответ 1xx (100 Continue, 103 Early Hints): за ним придёт
+        // окончательный, поэтому ни состояние, ни статус правил не трогаем
+        resp->interim = code >= 100 && code < 200;
+        if (resp->interim)
+            return total;
         // Начало нового ответа (например, после редиректа) – очищаем предыдущие заголовки и тело
         resp->headers.clear();
         resp->body.clear();
+        resp->dropBuffered();
+        resp->bodySize = 0;
+        if (resp->matcher)
+            resp->matcher->reset(resp->matchState);
+        if (resp->rules) {
+            resp->rules->reset(resp->ruleState);
+            resp->rules->onStatus(resp->ruleState, code);
+        }
+    }
+    // Заголовки промежуточного ответа пропускаем вместе с завершающей их пустой строкой
+    if (resp->interim) {
+        if (headerLine == "\r\n")
+            resp->interim = false;
+        return total;
     }
     // Если строка заголовка пуста (CRLF) – конец заголовков, не сохраняем ее
     if (headerLine == "\r\n") {
+        // Заголовки окончательного ответа (не редиректа, за которым пойдёт curl):
+        // если правила решены только по статусу и заголовкам, тело не скачиваем
+        if (resp->rules) {
+            long code = resp->ruleState.status;
+            bool redirect = code >= 300 && code < 400 && code != 304;
+            if (!redirect && resp->rules->endHeaders(resp->ruleState) &&
+                (!resp->matcher || resp->matcher->matched(resp->matchState))) {
+                resp->aborted = true;
+                return 0;
+            }
+        }
         return total;
     }
+    if (resp->rules)
+        resp->rules->feedHeader(resp->ruleState, *resp->ruleCache, ptr, total);
     // Сохраняем строку заголовка
-    resp->headers += headerLine;
+    resp->headers.append(ptr, total);
+    resp->buffered += total;
+    MemoryBudget::acquire(total);
     return total;
 }
-
-// Метод для одновременной загрузки нескольких URL
-// Возвращает HttpResponse для каждого URL, независимо от кода ответа или ошибок
-std::vector<HttpResponse> HttpClient::fetchMulti(const std::vector<std::string>& urls) {
-    std::vector<HttpResponse> responses;
-    responses.resize(urls.size());
-    // Инициализируем CURL multi-стек
-    CURLM *multi_handle = curl_multi_init();
-    if (!multi_handle) {
-        std::cerr << "Не удалось инициализировать curl_multi" << std::endl;
-        return responses;
-    }
-
-    // Создаем и настраиваем CURL easy handle для каждого URL
-    std::vector<CURL*> easy_handles(urls.size(), nullptr);
-    for (size_t i = 0; i < urls.size(); ++i) {
-        responses[i].url = urls[i];
-        CURL *easy = curl_easy_init();
-        if (!easy) {
-            std::cerr << "Не удалось инициализировать curl_easy для URL: "
-                      << urls[i] << std::endl;
-            continue;
-        }
-        easy_handles[i] = easy;
-
-        // Получаем указатель на соответствующую структуру ответа
-        HttpResponse *resp = &responses[i];
-
-        // Настраиваем URL запроса
-        curl_easy_setopt(easy, CURLOPT_URL, urls[i].c_str());
-        // Callback-и для тела и заголовков
-        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, HttpClient::writeCallback);
-        curl_easy_setopt(easy, CURLOPT_WRITEDATA, resp);
-        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, HttpClient::headerCallback);
-        curl_easy_setopt(easy, CURLOPT_HEADERDATA, resp);
-        // Разрешаем автоматическое перенаправление по Location
-        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(easy, CURLOPT_MAXREDIRS, 10L);
-        // Отключаем проверку SSL-сертификата (как указано в исходном коде)
-        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 0L);
-        // Отключаем использование сигналов (для таймаутов) – повышение стабильности при массовых запросах
-        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
-
-        // Добавляем easy-handle в multi-handle
-        CURLMcode mc = curl_multi_add_handle(multi_handle, easy);
-        if (mc != CURLM_OK) {
-            std::cerr << "Ошибка curl_multi_add_handle: "
-                      << curl_multi_strerror(mc) << std::endl;
-        }
-
-        // Сохраняем указатель на структуру ответа в easy-handle (для идентификации при завершении)
-        curl_easy_setopt(easy, CURLOPT_PRIVATE, resp);
-    }
-
-    // Запускаем мульти-запросы
-    int still_running = 0;
-    CURLMcode mc = curl_multi_perform(multi_handle, &still_running);
-    // Цикл обработки до завершения всех запросов
-    while (still_running) {
-        // Ожидаем активности (или таймаута) на мульти-хендле
-        mc = curl_multi_wait(multi_handle, nullptr, 0, 1000, nullptr);
-        if (mc != CURLM_OK) {
-            std::cerr << "Ошибка curl_multi_wait: "
-                      << curl_multi_strerror(mc) << std::endl;
-            break;
-        }
-        // Выполняем очередной проход мульти-запросов
-        mc = curl_multi_perform(multi_handle, &still_running);
-        if (mc != CURLM_OK) {
-            std::cerr << "Ошибка curl_multi_perform: "
-                      << curl_multi_strerror(mc) << std::endl;
-            break;
-        }
-    }
-
-    // Считываем результаты завершённых запросов
-    int msgs_left = 0;
-    CURLMsg *msg = nullptr;
-    while ((msg = curl_multi_info_read(multi_handle, &msgs_left))) {
-        if (msg->msg == CURLMSG_DONE) {
-            CURL *easy = msg->easy_handle;
-            HttpResponse *resp = nullptr;
-            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &resp);
-            // Получаем HTTP-код ответа
-            long http_code = 0;
-            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_code);
-            resp->code = http_code;
-            // Логируем результат (код CURL и HTTP, длина данных)
-            char *eff_url = nullptr;
-            curl_easy_getinfo(easy, CURLINFO_EFFECTIVE_URL, &eff_url);
-            if (msg->data.result != CURLE_OK) {
-                std::cerr << "URL: " << (eff_url ? eff_url : "")
-                          << " завершился ошибкой: " << curl_easy_strerror(msg->data.result)
-                          << " (CURL код " << msg->data.result << "), HTTP код: "
-                          << http_code << ", получено байт: " << resp->body.size()
-                          << std::endl;
-            } else {
-                std::cerr << "URL: " << (eff_url ? eff_url : "")
-                          << " успешно получен, HTTP код: " << http_code
-                          << ", размер: " << resp->body.size() << " байт" << std::endl;
-            }
-            // Удаляем обработанный easy-handle из мульти и очищаем его
-            curl_multi_remove_handle(multi_handle, easy);
-            curl_easy_cleanup(easy);
-            // Обнуляем указатель в массиве (на случай дальнейшей очистки)
-            size_t index = resp - &responses[0];
-            easy_handles[index] = nullptr;
-        }
-    }
-
-    // Очистка оставшихся дескрипторов (на случай преждевременного выхода из цикла)
-    for (CURL *easy : easy_handles) {
-        if (easy) {
-            curl_multi_remove_handle(multi_handle, easy);
-            curl_easy_cleanup(easy);
-        }
-    }
-    curl_multi_cleanup(multi_handle);
-
-    // Возвращаем массив результатов (HttpResponse) для всех URL,
-    // включая ошибки и коды != 200 (тело и заголовки сохранены)
-    return responses;
-}
@@ -5,39 +5,69 @@
 #include <string>
 #include <vector>
 #include <curl/curl.h>
+#include "KeywordMatcher.hpp"
+#include "RuleSet.hpp"
+
+// Времена фаз передачи из CURLINFO_*_TIME_T, микросекунды от начала запроса
+struct TransferTimings {
+    curl_off_t dns = 0;      // CURLINFO_NAMELOOKUP_TIME_T
+    curl_off_t connect = 0;  // CURLINFO_CONNECT_TIME_T
+    curl_off_t tls = 0;      // CURLINFO_APPCONNECT_TIME_T (0 — без TLS)
+    curl_off_t ttfb = 0;     // CURLINFO_STARTTRANSFER_TIME_T
+    curl_off_t total = 0;    // CURLINFO_TOTAL_TIME_T
+};
+
+// Причина принудительного завершения передачи циклом событий (см. TransferPool::Deadlines)
+enum class Eviction : uint8_t { None, Connect, Tls, FirstByte, Total, LowSpeed };
 
 struct HttpResponse {
     std::string url;
     std::string headers;
-    std::string body;
+    std::string body;     // заполняется только без matcher (буферизующий режим)
     long        code = 0; // HTTP response code (например, 200, 404, 301, ...), по умолчанию 0
-};
-
-class HttpClient {
-public:
-    HttpClient();
-    ~HttpClient();
-
-    // Синхронная загрузка (обычно используется для отладки)
-    bool fetch(const std::string& url, std::string& responseBody);
+    size_t      bodySize = 0; // сколько байт тела пришло
 
-    // Синхронная загрузка в файл
-    bool fetchToFile(const std::string& url, FILE* outfp);
+    // Итог передачи (заполняет TransferPool)
+    CURLcode        result = CURLE_OK;   // прерывание после совпадения считается успехом
+    std::string     effectiveUrl;        // URL после редиректов
+    curl_off_t      bytesReceived = 0;   // CURLINFO_SIZE_DOWNLOAD_T
+    TransferTimings timings;
+    uint64_t        ticket = 0;          // квота HostScheduler из FetchRequest
+    int             retries = 0;         // сколько повторов понадобилось (см. RetryPolicy)
+    Eviction        evicted = Eviction::None; // передача снята по сроку (result = CURLE_OPERATION_TIMEDOUT)
+    size_t          progressBytes = 0;   // все полученные байты заголовков и тел (для контроля скорости)
 
-    // Асинхронная загрузка одного URL (на самом деле делает запрос в фоне через curl_multi)
-    bool fetchAsync(const std::string& url, std::string& responseBody);
+    // Потоковый режим: тело не сохраняется, а сразу подаётся в matcher
+    const KeywordMatcher* matcher = nullptr;
+    KeywordMatcher::State matchState;
+    // Правила --rules: заголовки и тело проходят через автоматы RuleSet
+    const RuleSet* rules = nullptr;
+    RuleSet::Cache* ruleCache = nullptr; // автоматы потока (см. TransferPool::setRules)
+    RuleSet::State ruleState;
+    bool        aborted = false; // передача прервана, т.к. решение по совпадению уже принято
+    size_t      maxBytes = 0;    // бюджет тела ответа (--max-bytes), 0 — без ограничения
+    bool        truncated = false; // передача прервана по бюджету maxBytes
+    bool        fellBack = false;  // https не ответил, результат получен по http (см. FetchRequest)
+    bool        interim = false;   // идут заголовки промежуточного ответа 1xx (см. headerCallback)
+    size_t      buffered = 0;      // байт в headers/body, учтённых в MemoryBudget
 
-    // Множественная асинхронная загрузка (гарантирует возврат даже при ошибках)
-    std::vector<HttpResponse> fetchMulti(const std::vector<std::string>& urls);
+    // Готовит ответ к следующей передаче того же слота: поля сбрасываются, а память
+    // строк и состояний остаётся (буферы слота — арена, очищаемая после каждого результата).
+    // Слишком выросшие буферы отдаются системе, чтобы один большой ответ не держал RSS.
+    void recycle();
+    // Освобождает учтённые байты headers/body (например, перед ответом после редиректа)
+    void dropBuffered();
+};
 
+// Callback-и libcurl для ответа. Передачи ведёт TransferPool, глобальную
+// инициализацию libcurl — CurlShare.
+class HttpClient {
+public:
     // Позволяет использовать writeCallback как нестатическую функцию (опционально)
     static size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
 
     // Позволяет использовать headerCallback как нестатическую функцию (опционально)
     static size_t headerCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
-
-private:
-    CURL* curlHandle = nullptr; // Используется только для одиночных fetch
 };
 
 #endif // HTTPCLIENT_HPP
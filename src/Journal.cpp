@@ -0,0 +1,119 @@
+// src/Journal.cpp
+#include "Journal.hpp"
+#include "Logger.hpp"
+#include "ResultWriter.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+constexpr char   kMagic[8] = {'F', 'C', 'J', '1', 0, 0, 0, 0};
+constexpr size_t kHeaderSize = sizeof(kMagic);
+constexpr size_t kRecordSize = sizeof(uint64_t);
+}
+
+int                 Journal::fd = -1;
+FingerprintSet      Journal::done;
+std::atomic<size_t> Journal::skipped{0};
+
+bool Journal::open(const std::string& path, bool resume) {
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (resume ? 0 : O_TRUNC);
+    fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        Logger::error("Journal: не удалось открыть %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        Logger::error("Journal: fstat %s: %s", path.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    if (size < kHeaderSize) {
+        // Новый (или оборванный на заголовке) журнал
+        if (::ftruncate(fd, 0) != 0 || ::pwrite(fd, kMagic, kHeaderSize, 0) != static_cast<ssize_t>(kHeaderSize)) {
+            Logger::error("Journal: не удалось записать заголовок %s: %s", path.c_str(), std::strerror(errno));
+            close();
+            return false;
+        }
+        size = kHeaderSize;
+    } else {
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            Logger::error("Journal: mmap %s: %s", path.c_str(), std::strerror(errno));
+            close();
+            return false;
+        }
+        const char* base = static_cast<const char*>(map);
+        if (std::memcmp(base, kMagic, kHeaderSize) != 0) {
+            Logger::error("Journal: %s не является журналом обхода", path.c_str());
+            ::munmap(map, size);
+            close();
+            return false;
+        }
+        size_t records = (size - kHeaderSize) / kRecordSize;
+        ::madvise(map, size, MADV_SEQUENTIAL);
+        done.reserve(records);
+        for (size_t i = 0; i < records; ++i) {
+            uint64_t fp = 0;
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(base + kHeaderSize + i * kRecordSize);
+            for (size_t b = 0; b < kRecordSize; ++b)
+                fp |= static_cast<uint64_t>(p[b]) << (8 * b);
+            if (fp)
+                done.insert(fp);
+        }
+        ::munmap(map, size);
+        // Оборванную запись в хвосте отрезаем, чтобы новые записи легли по границе
+        size = kHeaderSize + records * kRecordSize;
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+            Logger::error("Journal: не удалось обрезать %s: %s", path.c_str(), std::strerror(errno));
+        Logger::info("Journal: %zu domains already completed", done.size());
+    }
+
+    if (::lseek(fd, static_cast<off_t>(size), SEEK_SET) < 0) {
+        Logger::error("Journal: lseek %s: %s", path.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+    ResultWriter::setJournal(fd);
+    return true;
+}
+
+void Journal::close() {
+    if (fd >= 0) {
+        if (skipped.load())
+            Logger::info("Journal: skipped %zu completed domains", skipped.load());
+        ResultWriter::setJournal(-1);
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+uint64_t Journal::key(std::string_view domain) {
+    while (!domain.empty() && static_cast<unsigned char>(domain.front()) <= ' ')
+        domain.remove_prefix(1);
+    while (!domain.empty() && static_cast<unsigned char>(domain.back()) <= ' ')
+        domain.remove_suffix(1);
+    size_t scheme = domain.find("://");
+    if (scheme != std::string_view::npos)
+        domain.remove_prefix(scheme + 3);
+    return FingerprintSet::fingerprint(domain);
+}
+
+bool Journal::isDone(std::string_view domain) {
+    if (done.empty() || !done.contains(key(domain)))
+        return false;
+    skipped.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void Journal::markDone(std::string_view domain) {
+    if (fd >= 0)
+        ResultWriter::markDone(key(domain));
+}
@@ -0,0 +1,45 @@
+// src/Journal.hpp
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include "FingerprintSet.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Журнал завершённых доменов для продолжения прерванного прогона (--journal, --resume).
+// Файл только дописывается: заголовок "FCJ1" + 4 нулевых байта, затем 64-битные
+// отпечатки доменов (little-endian). Записи копит и пишет пачками ResultWriter —
+// строго после результатов того же сброса, поэтому домен считается выполненным,
+// только когда его результат уже в файле. Оборванная при сбое запись в хвосте
+// отбрасывается при открытии.
+// При --resume журнал отображается в память и загружается в FingerprintSet;
+// проверка домена — одно обращение к таблице, до DNS и до загрузки.
+class Journal {
+public:
+    // resume = false — журнал создаётся заново; true — загружается и дописывается
+    static bool open(const std::string& path, bool resume);
+    static void close();
+
+    static bool enabled() { return fd >= 0; }
+
+    // Отпечаток домена: пробелы по краям и схема ("http://") не учитываются
+    static uint64_t key(std::string_view domain);
+
+    // Домен уже обработан в прошлом прогоне (считается в статистике пропусков)
+    static bool isDone(std::string_view domain);
+
+    // Отмечает домен выполненным (вызывается после записи его результата)
+    static void markDone(std::string_view domain);
+
+    static size_t loadedCount() { return done.size(); }
+    static size_t skippedCount() { return skipped.load(std::memory_order_relaxed); }
+
+private:
+    static int fd;
+    static FingerprintSet done;
+    static std::atomic<size_t> skipped;
+};
+
+#endif // JOURNAL_HPP
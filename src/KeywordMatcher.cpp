@@ -0,0 +1,188 @@
+// src/KeywordMatcher.cpp
+#include "KeywordMatcher.hpp"
+#include "CaseSearch.hpp"
+#include <algorithm>
+#include <cctype>
+#include <queue>
+
+KeywordMatcher::KeywordMatcher(const std::vector<std::string>& words) {
+    compile(words);
+}
+
+void KeywordMatcher::compile(const std::vector<std::string>& words) {
+    patterns.clear();
+    for (const auto& w : words) {
+        if (w.empty())
+            continue;
+        std::string lower = w;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (std::find(patterns.begin(), patterns.end(), lower) == patterns.end())
+            patterns.push_back(std::move(lower));
+    }
+
+    maxLen = 0;
+    for (const auto& p : patterns)
+        maxLen = std::max(maxLen, p.size());
+    direct = !patterns.empty() && patterns.size() <= kDirectMaxWords;
+
+    // Классы символов: только байты, встречающиеся в словах, остальные -> 0.
+    // Заглавные буквы отображаются в тот же класс, что и строчные.
+    std::fill(std::begin(classOf), std::end(classOf), 0);
+    numClasses = 1;
+    for (const auto& p : patterns) {
+        for (unsigned char c : p) {
+            if (!classOf[c])
+                classOf[c] = static_cast<uint8_t>(numClasses++);
+        }
+    }
+    for (int c = 'A'; c <= 'Z'; ++c)
+        classOf[c] = classOf[c - 'A' + 'a'];
+
+    // Бор
+    const uint32_t none = UINT32_MAX;
+    std::vector<uint32_t> trie(numClasses, none);
+    std::vector<std::vector<uint32_t>> own(1);
+    for (uint32_t i = 0; i < patterns.size(); ++i) {
+        uint32_t s = 0;
+        for (unsigned char c : patterns[i]) {
+            uint32_t& next = trie[s * numClasses + classOf[c]];
+            if (next == none) {
+                next = static_cast<uint32_t>(own.size());
+                own.emplace_back();
+                trie.resize(trie.size() + numClasses, none);
+            }
+            s = trie[s * numClasses + classOf[c]];
+        }
+        own[s].push_back(i);
+    }
+
+    // Суффиксные ссылки и полный автомат переходов (обход в ширину)
+    const size_t states = own.size();
+    delta.assign(states * numClasses, 0);
+    std::vector<uint32_t> fail(states, 0);
+    std::vector<uint32_t> order;
+    order.reserve(states);
+    std::queue<uint32_t> q;
+    for (uint32_t c = 0; c < numClasses; ++c) {
+        uint32_t v = trie[c];
+        if (v != none) {
+            delta[c] = v;
+            q.push(v);
+        }
+    }
+    while (!q.empty()) {
+        uint32_t u = q.front();
+        q.pop();
+        order.push_back(u);
+        for (uint32_t c = 0; c < numClasses; ++c) {
+            uint32_t v = trie[u * numClasses + c];
+            if (v != none) {
+                fail[v] = delta[fail[u] * numClasses + c];
+                delta[u * numClasses + c] = v;
+                q.push(v);
+            } else {
+                delta[u * numClasses + c] = delta[fail[u] * numClasses + c];
+            }
+        }
+    }
+
+    // Выходы состояния = собственные слова + выходы суффиксной ссылки
+    for (uint32_t u : order) {
+        const auto& inherited = own[fail[u]];
+        own[u].insert(own[u].end(), inherited.begin(), inherited.end());
+    }
+    outStart.assign(states + 1, 0);
+    outList.clear();
+    for (size_t s = 0; s < states; ++s) {
+        outStart[s] = static_cast<uint32_t>(outList.size());
+        outList.insert(outList.end(), own[s].begin(), own[s].end());
+    }
+    outStart[states] = static_cast<uint32_t>(outList.size());
+
+    // Переводим переходы в смещения строк и помечаем состояния с выходами,
+    // чтобы в горячем цикле не было умножения и лишних обращений к outStart
+    for (auto& next : delta) {
+        uint32_t row = next * numClasses;
+        if (outStart[next] != outStart[next + 1])
+            row |= kOutputFlag;
+        next = row;
+    }
+}
+
+void KeywordMatcher::reset(State& st) const {
+    st.node = 0;
+    st.remaining = patterns.size();
+    st.found.assign((patterns.size() + 63) / 64, 0);
+    st.tail.clear();
+}
+
+bool KeywordMatcher::markFound(State& st, uint32_t w) const {
+    uint64_t bit = uint64_t(1) << (w & 63);
+    if (!(st.found[w >> 6] & bit)) {
+        st.found[w >> 6] |= bit;
+        --st.remaining;
+    }
+    return st.remaining == 0;
+}
+
+bool KeywordMatcher::feed(State& st, const char* data, size_t len) const {
+    if (st.remaining == 0)
+        return true;
+    return direct ? feedDirect(st, data, len) : feedAutomaton(st, data, len);
+}
+
+bool KeywordMatcher::feedDirect(State& st, const char* data, size_t len) const {
+    const size_t keep = maxLen - 1;
+
+    // Стык с предыдущим куском: хвост + начало текущего куска
+    if (!st.tail.empty()) {
+        st.tail.append(data, std::min(len, keep));
+        for (uint32_t w = 0; w < patterns.size(); ++w) {
+            if (st.found[w >> 6] & (uint64_t(1) << (w & 63)))
+                continue;
+            const std::string& p = patterns[w];
+            if (CaseSearch::find(st.tail.data(), st.tail.size(), p.data(), p.size()) != CaseSearch::npos &&
+                markFound(st, w))
+                return true;
+        }
+    }
+
+    for (uint32_t w = 0; w < patterns.size(); ++w) {
+        if (st.found[w >> 6] & (uint64_t(1) << (w & 63)))
+            continue;
+        const std::string& p = patterns[w];
+        if (CaseSearch::find(data, len, p.data(), p.size()) != CaseSearch::npos &&
+            markFound(st, w))
+            return true;
+    }
+
+    // Сохраняем последние maxLen-1 байт для проверки следующего стыка
+    if (len >= keep)
+        st.tail.assign(data + len - keep, keep);
+    else if (st.tail.empty())
+        st.tail.assign(data, len);
+    else if (st.tail.size() > keep)
+        st.tail.erase(0, st.tail.size() - keep);
+    return false;
+}
+
+bool KeywordMatcher::feedAutomaton(State& st, const char* data, size_t len) const {
+    const uint32_t* d = delta.data();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    uint32_t row = st.node;
+    for (size_t i = 0; i < len; ++i) {
+        row = d[(row & ~kOutputFlag) + classOf[p[i]]];
+        if (row & kOutputFlag) {
+            uint32_t s = (row & ~kOutputFlag) / numClasses;
+            for (uint32_t b = outStart[s], e = outStart[s + 1]; b < e; ++b) {
+                if (markFound(st, outList[b])) {
+                    st.node = row & ~kOutputFlag;
+                    return true;
+                }
+            }
+        }
+    }
+    st.node = row & ~kOutputFlag;
+    return false;
+}
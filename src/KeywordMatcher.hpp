@@ -0,0 +1,67 @@
+// src/KeywordMatcher.hpp
+#ifndef KEYWORDMATCHER_HPP
+#define KEYWORDMATCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Потоковый регистронезависимый (ASCII) поиск набора слов — автомат Ахо-Корасик.
+// Автомат компилируется один раз; каждая передача хранит только небольшой State,
+// поэтому тело ответа можно подавать кусками по мере прихода, не сохраняя его.
+// Семантика --contains: совпадение, когда найдены ВСЕ слова.
+// Для небольшого числа слов вместо автомата каждое слово ищется векторным
+// ядром CaseSearch, а стык кусков проверяется по сохранённому хвосту.
+class KeywordMatcher {
+public:
+    struct State {
+        uint32_t              node = 0;      // текущая строка автомата (переживает границы кусков)
+        size_t                remaining = 0; // сколько слов ещё не найдено
+        std::vector<uint64_t> found;         // битовая маска найденных слов
+        std::string           tail;          // последние maxLen-1 байт (только для прямого поиска)
+    };
+
+    // До скольких слов выгоднее прямой векторный поиск, чем проход автоматом
+    static constexpr size_t kDirectMaxWords = 16;
+
+    KeywordMatcher() = default;
+    explicit KeywordMatcher(const std::vector<std::string>& words);
+
+    void compile(const std::vector<std::string>& words);
+
+    // Подготавливает состояние к новому ответу (например, после редиректа)
+    void reset(State& st) const;
+
+    // Обрабатывает очередной кусок тела. Возвращает true, когда решение окончательное
+    // (все слова найдены) и дальнейшие данные можно не скачивать.
+    bool feed(State& st, const char* data, size_t len) const;
+
+    bool matched(const State& st) const { return st.remaining == 0; }
+
+    // Уникальные слова в нижнем регистре (в порядке первого появления)
+    const std::vector<std::string>& words() const { return patterns; }
+
+    // Принудительный выбор алгоритма (для бенчмарков)
+    void setDirect(bool on) { direct = on && !patterns.empty(); }
+    bool isDirect() const { return direct; }
+
+private:
+    bool feedAutomaton(State& st, const char* data, size_t len) const;
+    bool feedDirect(State& st, const char* data, size_t len) const;
+    bool markFound(State& st, uint32_t w) const;
+
+    std::vector<std::string> patterns;
+    size_t                   maxLen = 0;
+    bool                     direct = false;
+    uint8_t                  classOf[256] = {};  // байт -> класс символа (0 — байт не встречается в словах)
+    uint32_t                 numClasses = 1;
+    // Переходы: delta[row + class] = строка следующего состояния (state * numClasses);
+    // старший бит помечает состояния, в которых заканчивается хотя бы одно слово
+    std::vector<uint32_t>    delta;
+    std::vector<uint32_t>    outStart;           // выходы состояния: outList[outStart[s] .. outStart[s+1])
+    static constexpr uint32_t kOutputFlag = 0x80000000u;
+    std::vector<uint32_t>    outList;
+};
+
+#endif // KEYWORDMATCHER_HPP
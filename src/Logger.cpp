@@ -1,25 +1,250 @@
 // src/Logger.cpp
 #include "Logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
 
 Logger::Level Logger::currentLevel = Logger::Level::Info;
 std::mutex    Logger::mtx;
+std::vector<std::unique_ptr<Logger::Ring>> Logger::rings;
+std::atomic<bool> Logger::running{false};
+bool          Logger::stopping = false;
+std::condition_variable Logger::wakeup;
+std::thread   Logger::drainThread;
+int           Logger::fd = STDERR_FILENO;
+uint64_t      Logger::stampSec = 0;
+char          Logger::stamp[20] = {};
 
-void Logger::init(Level level) {
+namespace {
+
+// Сообщений в секунду с одного места вызова в одном потоке
+constexpr uint32_t kSiteRate = 20;
+constexpr int      kDrainMs = 50;
+
+const char* levelName(Logger::Level l) {
+    return l == Logger::Level::Error ? "ERROR" : l == Logger::Level::Info ? "INFO" : "DEBUG";
+}
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void writeAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        done += static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+bool Logger::init(Level level, const std::string& path) {
     currentLevel = level;
+    if (!path.empty()) {
+        int f = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (f < 0) {
+            error("Failed to open log file %s: %s", path.c_str(), std::strerror(errno));
+            return false;
+        }
+        fd = f;
+    }
+    if (running.exchange(true))
+        return true;
+    stopping = false;
+    drainThread = std::thread(&Logger::run);
+    static bool registered = false;
+    if (!registered) {
+        registered = true;
+        std::atexit(&Logger::shutdown);
+    }
+    return true;
+}
+
+void Logger::shutdown() {
+    if (!running.load())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (drainThread.joinable())
+        drainThread.join();
+    running = false;
+}
+
+Logger::Ring& Logger::localRing() {
+    thread_local Ring* ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(mtx);
+        rings.push_back(std::make_unique<Ring>());
+        ring = rings.back().get();
+    }
+    return *ring;
+}
+
+// Окно в одну секунду на строку формата (литерал — адрес однозначно задаёт место вызова).
+// Возвращает SIZE_MAX, если сообщение подавлено, иначе число подавленных до него.
+size_t Logger::throttle(const char* fmt, uint64_t sec) {
+    struct Site {
+        const char* fmt = nullptr;
+        uint64_t    sec = 0;
+        uint32_t    count = 0;
+        uint32_t    suppressed = 0;
+    };
+    constexpr size_t kSites = 64;
+    thread_local Site sites[kSites];
+
+    size_t h = (reinterpret_cast<uintptr_t>(fmt) >> 3) % kSites;
+    for (size_t probe = 0; probe < 4; ++probe) {
+        Site& s = sites[(h + probe) % kSites];
+        if (s.fmt && s.fmt != fmt)
+            continue;
+        s.fmt = fmt;
+        if (s.sec != sec) {
+            s.sec = sec;
+            s.count = 0;
+        }
+        if (++s.count > kSiteRate) {
+            ++s.suppressed;
+            return SIZE_MAX;
+        }
+        size_t suppressed = s.suppressed;
+        s.suppressed = 0;
+        return suppressed;
+    }
+    return 0; // таблица мест занята — без ограничения
 }
 
 void Logger::log(Level msgLevel, const char* fmt, va_list args) {
-    if (msgLevel <= currentLevel) {
+    if (msgLevel > currentLevel)
+        return;
+    if (!running.load(std::memory_order_relaxed)) {
+        logSync(msgLevel, fmt, args);
+        return;
+    }
+    uint64_t ns = nowNs();
+    size_t suppressed = 0;
+    if (msgLevel != Level::Debug) {
+        suppressed = throttle(fmt, ns / 1000000000ull);
+        if (suppressed == SIZE_MAX)
+            return;
+    }
+
+    Ring& ring = localRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= Ring::kSlots) {
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    Record& r = ring.slots[head % Ring::kSlots];
+    int n = std::vsnprintf(r.text, Record::kTextSize, fmt, args);
+    size_t len = n < 0 ? 0 : std::min<size_t>(static_cast<size_t>(n), Record::kTextSize - 1);
+    if (suppressed) {
+        int m = std::snprintf(r.text + len, Record::kTextSize - len, " [ещё %zu таких сообщений подавлено]", suppressed);
+        if (m > 0)
+            len = std::min<size_t>(len + static_cast<size_t>(m), Record::kTextSize - 1);
+    }
+    r.ns = ns;
+    r.len = static_cast<uint16_t>(len);
+    r.level = msgLevel;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Logger::logSync(Level msgLevel, const char* fmt, va_list args) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string line;
+    appendStamp(line, nowNs() / 1000000000ull);
+    line.append(" [").append(levelName(msgLevel)).append("] ");
+    char buf[4096];
+    int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+    if (n > 0)
+        line.append(buf, std::min<size_t>(static_cast<size_t>(n), sizeof(buf) - 1));
+    line.push_back('\n');
+    writeAll(fd, line);
+}
+
+void Logger::appendStamp(std::string& out, uint64_t sec) {
+    if (sec != stampSec || !stamp[0]) {
+        std::time_t t = static_cast<std::time_t>(sec);
+        std::tm tm;
+        localtime_r(&t, &tm);
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+        stampSec = sec;
+    }
+    out.append(stamp);
+}
+
+// Забирает записи всех колец в порядке времени; возвращает их число
+size_t Logger::drain(std::string& out) {
+    struct Pending {
+        uint64_t      ns;
+        const Record* rec;
+    };
+    thread_local std::vector<Pending> pending;
+    thread_local std::vector<std::pair<Ring*, uint64_t>> claimed;
+    pending.clear();
+    claimed.clear();
+    {
         std::lock_guard<std::mutex> lock(mtx);
-        const char* lvl = (msgLevel == Level::Error ? "ERROR" :
-                           msgLevel == Level::Info  ? "INFO"  :
-                                                      "DEBUG");
-        std::time_t t = std::time(nullptr);
-        char tb[20];
-        std::strftime(tb, sizeof(tb), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
-        std::fprintf(stderr, "%s [%s] ", tb, lvl);
-        std::vfprintf(stderr, fmt, args);
-        std::fprintf(stderr, "\n");
+        for (auto& ring : rings) {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (uint64_t i = tail; i < head; ++i) {
+                const Record& r = ring->slots[i % Ring::kSlots];
+                pending.push_back({r.ns, &r});
+            }
+            claimed.emplace_back(ring.get(), head);
+
+            uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+            if (dropped != ring->reported) {
+                appendStamp(out, nowNs() / 1000000000ull);
+                out.append(" [ERROR] Logger: буфер потока переполнен, потеряно сообщений: ")
+                    .append(std::to_string(dropped - ring->reported)).push_back('\n');
+                ring->reported = dropped;
+            }
+        }
+    }
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const Pending& a, const Pending& b) { return a.ns < b.ns; });
+    for (const Pending& p : pending) {
+        appendStamp(out, p.ns / 1000000000ull);
+        out.append(" [").append(levelName(p.rec->level)).append("] ");
+        out.append(p.rec->text, p.rec->len).push_back('\n');
+    }
+    // Слоты освобождаются только после копирования текста
+    for (auto& c : claimed)
+        c.first->tail.store(c.second, std::memory_order_release);
+    return pending.size();
+}
+
+void Logger::run() {
+    std::string out;
+    bool last = false;
+    while (!last) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            last = wakeup.wait_for(lock, std::chrono::milliseconds(kDrainMs), [] { return stopping; });
+        }
+        // После остановки дочитываем, пока кольца не опустеют
+        do {
+            out.clear();
+            drain(out);
+            if (!out.empty())
+                writeAll(fd, out);
+        } while (last && !out.empty());
     }
 }
 
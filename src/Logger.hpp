@@ -2,25 +2,76 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
-#include <string>
-#include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdio>
-#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+// Асинхронный журнал. Поток форматирует сообщение прямо в слот своего кольца
+// (один писатель, один читатель, без блокировок); отдельный поток вывода раз в
+// несколько десятков миллисекунд забирает записи всех колец, упорядочивает их по
+// времени и пишет одним write в stderr или --logfile. Метка времени форматируется
+// в потоке вывода и кэшируется на секунду.
+// Переполненное кольцо не блокирует поток: сообщение отбрасывается и учитывается.
+// Сообщения уровней Error и Info ограничены по частоте для каждого места вызова
+// (строки формата) в каждом потоке; о подавленных сообщается в следующей записи.
+// До init и после shutdown запись синхронная.
 class Logger {
 public:
     enum class Level { Error = 0, Info = 1, Debug = 2 };
 
-    static void init(Level level = Level::Info);
-    static void error(const char* fmt, ...);
-    static void info (const char* fmt, ...);
-    static void debug(const char* fmt, ...);
+    // path — файл журнала (дописывается), пустая строка — stderr
+    static bool init(Level level = Level::Info, const std::string& path = std::string());
+    // Выводит всё накопленное и останавливает поток вывода; вызывается и при выходе из процесса
+    static void shutdown();
+
+    static void error(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+    static void info (const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+    static void debug(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
 
 private:
+    struct Record {
+        static constexpr size_t kTextSize = 500;
+        uint64_t ns = 0;    // CLOCK_REALTIME_COARSE
+        uint16_t len = 0;
+        Level    level = Level::Info;
+        char     text[kTextSize];
+    };
+
+    // Кольцо одного потока: head двигает писатель, tail — поток вывода
+    struct Ring {
+        static constexpr size_t kSlots = 512;
+        alignas(64) std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint64_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        uint64_t              reported = 0; // сколько потерь уже сообщено (поток вывода)
+        Record                slots[kSlots];
+    };
+
+    static void log(Level msgLevel, const char* fmt, va_list args);
+    static void logSync(Level msgLevel, const char* fmt, va_list args);
+    static size_t throttle(const char* fmt, uint64_t sec);
+    static Ring& localRing();
+    static void run();
+    static size_t drain(std::string& out);
+    static void appendStamp(std::string& out, uint64_t sec);
+
     static Level    currentLevel;
-    static std::mutex mtx;
-    static void     log(Level msgLevel, const char* fmt, va_list args);
+    static std::mutex mtx;                 // реестр колец, синхронная запись
+    static std::vector<std::unique_ptr<Ring>> rings;
+    static std::atomic<bool> running;
+    static bool     stopping;
+    static std::condition_variable wakeup;
+    static std::thread drainThread;
+    static int      fd;
+    static uint64_t stampSec;              // секунда, для которой отформатирован stamp
+    static char     stamp[20];
 };
 
 #endif // LOGGER_HPP
@@ -0,0 +1,87 @@
+// src/MappedInput.cpp
+#include "MappedInput.hpp"
+#include "Logger.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+MappedInput::~MappedInput() {
+    if (base && length)
+        ::munmap(const_cast<char*>(base), length);
+}
+
+bool MappedInput::open(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::error("Failed to open domain file: %s (%s)", filename.c_str(), std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        Logger::error("Failed to stat domain file: %s (%s)", filename.c_str(), std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        Logger::error("Failed to mmap domain file: %s (%s)", filename.c_str(), std::strerror(errno));
+        length = 0;
+        return false;
+    }
+    // Каждый поток читает свой диапазон строго последовательно
+    ::madvise(p, length, MADV_SEQUENTIAL);
+    base = static_cast<const char*>(p);
+    return true;
+}
+
+std::vector<MappedInput::Range> MappedInput::split(size_t parts) const {
+    std::vector<Range> ranges;
+    if (parts == 0)
+        parts = 1;
+    size_t begin = 0;
+    for (size_t i = 1; i <= parts; ++i) {
+        size_t end = (i == parts) ? length : length / parts * i;
+        // Сдвигаем границу за ближайший перевод строки
+        if (end <= begin) {
+            end = begin;
+        } else if (end < length) {
+            const void* nl = std::memchr(base + end, '\n', length - end);
+            end = nl ? static_cast<size_t>(static_cast<const char*>(nl) - base) + 1 : length;
+        }
+        ranges.push_back(Range{begin, end});
+        begin = end;
+    }
+    return ranges;
+}
+
+bool MappedInput::Cursor::next(std::string_view& line, uint64_t& offset) {
+    while (pos < end) {
+        const char* start = base + pos;
+        const void* nl = std::memchr(start, '\n', end - pos);
+        size_t len = nl ? static_cast<size_t>(static_cast<const char*>(nl) - start) : end - pos;
+        offset = pos;
+        pos += len + (nl ? 1 : 0);
+
+        // Обрезаем пробелы и \r по краям
+        size_t b = 0, e = len;
+        while (b < e && (start[b] == ' ' || start[b] == '\t' || start[b] == '\r'))
+            ++b;
+        while (e > b && (start[e - 1] == ' ' || start[e - 1] == '\t' || start[e - 1] == '\r'))
+            --e;
+        if (e > b) {
+            line = std::string_view(start + b, e - b);
+            offset += b;
+            return true;
+        }
+    }
+    return false;
+}
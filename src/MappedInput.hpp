@@ -0,0 +1,59 @@
+// src/MappedInput.hpp
+#ifndef MAPPEDINPUT_HPP
+#define MAPPEDINPUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Входной файл, отображённый в память целиком (режим --input-mode=mmap).
+// Файл делится на диапазоны байт, выровненные по границам строк, — по одному
+// на поток-воркер, поэтому центральная очередь не нужна. Домены отдаются как
+// string_view в отображение; строки копируются только при построении URL.
+class MappedInput {
+public:
+    // Диапазон [begin, end) внутри отображения
+    struct Range {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    // Последовательное чтение строк одного диапазона
+    class Cursor {
+    public:
+        Cursor() = default;
+        Cursor(const char* base, Range r) : base(base), pos(r.begin), end(r.end) {}
+
+        // Следующая непустая строка без \r\n и пробелов по краям; offset — её смещение в файле
+        bool next(std::string_view& line, uint64_t& offset);
+
+    private:
+        const char* base = nullptr;
+        size_t pos = 0;
+        size_t end = 0;
+    };
+
+    MappedInput() = default;
+    ~MappedInput();
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    bool open(const std::string& filename);
+
+    size_t size() const { return length; }
+    const char* data() const { return base; }
+
+    // Делит файл на parts диапазонов примерно равного размера по границам строк
+    std::vector<Range> split(size_t parts) const;
+
+    Cursor cursor(Range r) const { return Cursor(base, r); }
+
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+};
+
+#endif // MAPPEDINPUT_HPP
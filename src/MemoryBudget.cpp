@@ -0,0 +1,5 @@
+// src/MemoryBudget.cpp
+#include "MemoryBudget.hpp"
+
+size_t              MemoryBudget::limit = 0;
+std::atomic<size_t> MemoryBudget::used{0};
@@ -0,0 +1,35 @@
+// src/MemoryBudget.hpp
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// Общий для процесса бюджет буферизованных данных (--memory-budget): заголовки и
+// тела ответов в слотах TransferPool и ещё не записанные результаты ResultWriter.
+// Пока объём выше предела, воркеры не начинают новые передачи — уже идущие
+// завершаются и освобождают память. Без предела учёт не ведётся вовсе.
+class MemoryBudget {
+public:
+    // Вызывается из main до запуска потоков; 0 — без ограничения
+    static void setLimit(size_t bytes) { limit = bytes; }
+    static size_t limitBytes() { return limit; }
+
+    static void acquire(size_t n) {
+        if (limit)
+            used.fetch_add(n, std::memory_order_relaxed);
+    }
+    static void release(size_t n) {
+        if (limit)
+            used.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    static bool exceeded() { return limit && used.load(std::memory_order_relaxed) > limit; }
+    static size_t usedBytes() { return used.load(std::memory_order_relaxed); }
+
+private:
+    static size_t              limit;
+    static std::atomic<size_t> used;
+};
+
+#endif // MEMORYBUDGET_HPP
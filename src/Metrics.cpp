@@ -0,0 +1,261 @@
+// src/Metrics.cpp
+#include "Metrics.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+
+std::mutex                           Metrics::mtx;
+std::vector<std::unique_ptr<Metrics::Shard>> Metrics::shards;
+std::vector<Metrics::Gauge>          Metrics::gauges;
+std::thread                          Metrics::progressThread;
+std::condition_variable              Metrics::wakeup;
+bool                                 Metrics::stopping = false;
+
+namespace {
+
+const char* const kLatencyNames[] = {"dns", "connect", "tls", "ttfb", "total"};
+
+// Экспортируемые границы гистограмм: степени двойки от 64 мкс до ~134 с
+constexpr unsigned kFirstExportPow = 6;
+constexpr unsigned kLastExportPow = 27;
+
+void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+void appendf(std::string& out, const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0)
+        out.append(buf, std::min<size_t>(static_cast<size_t>(n), sizeof(buf) - 1));
+}
+
+void header(std::string& out, const char* name, const char* type, const char* help) {
+    appendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// 1234567 мкс -> "1.23 s", 4500 -> "4.5 ms"
+std::string formatUs(uint64_t us) {
+    char buf[32];
+    if (us >= 1000000)
+        std::snprintf(buf, sizeof(buf), "%.2f s", us / 1e6);
+    else if (us >= 1000)
+        std::snprintf(buf, sizeof(buf), "%.1f ms", us / 1e3);
+    else
+        std::snprintf(buf, sizeof(buf), "%llu us", static_cast<unsigned long long>(us));
+    return buf;
+}
+
+} // namespace
+
+unsigned Metrics::Histogram::bucketOf(uint64_t v) {
+    if (v < kSub)
+        return static_cast<unsigned>(v);
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(v));
+    unsigned shift = msb - kSubBits;
+    unsigned idx = (shift + 1) * kSub + static_cast<unsigned>((v >> shift) & (kSub - 1));
+    return std::min(idx, kBuckets - 1);
+}
+
+uint64_t Metrics::Histogram::upperBound(unsigned bucket) {
+    if (bucket < kSub)
+        return bucket;
+    unsigned shift = bucket / kSub - 1;
+    uint64_t lower = static_cast<uint64_t>(kSub + bucket % kSub) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+uint64_t Metrics::Snapshot::quantile(Latency l, double q) const {
+    uint64_t count = 0;
+    for (unsigned b = 0; b < Histogram::kBuckets; ++b)
+        count += latency[l][b];
+    if (!count)
+        return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < Histogram::kBuckets; ++b) {
+        seen += latency[l][b];
+        if (seen >= rank)
+            return Histogram::upperBound(b);
+    }
+    return Histogram::upperBound(Histogram::kBuckets - 1);
+}
+
+Metrics::Shard& Metrics::local() {
+    thread_local Shard* shard = nullptr;
+    if (!shard) {
+        std::lock_guard<std::mutex> lock(mtx);
+        shards.push_back(std::make_unique<Shard>());
+        shard = shards.back().get();
+    }
+    return *shard;
+}
+
+void Metrics::record(const HttpResponse& resp, bool matched) {
+    Shard& s = local();
+    bump(s.requests, 1);
+    bump(s.bytes, static_cast<uint64_t>(std::max<curl_off_t>(resp.bytesReceived, 0)));
+    if (matched)
+        bump(s.matched, 1);
+    if (resp.retries)
+        bump(s.retries, static_cast<uint64_t>(resp.retries));
+    if (resp.evicted != Eviction::None)
+        bump(s.evicted, 1);
+    unsigned code = std::min<unsigned>(static_cast<unsigned>(resp.result), kCurlCodes - 1);
+    bump(s.byCurl[code], 1);
+    long cls = resp.code / 100;
+    bump(s.byClass[cls >= 1 && cls <= 5 ? cls : 0], 1);
+    // Нулевые времена — фаза не состоялась (нет TLS, соединение не установлено)
+    const TransferTimings& tm = resp.timings;
+    const curl_off_t values[kLatencies] = {tm.dns, tm.connect, tm.tls, tm.ttfb, tm.total};
+    for (unsigned l = 0; l < kLatencies; ++l) {
+        if (values[l] > 0)
+            s.latency[l].record(static_cast<uint64_t>(values[l]));
+    }
+}
+
+void Metrics::addGauge(const std::string& name, const std::string& help, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mtx);
+    gauges.push_back(Gauge{name, help, std::move(read)});
+}
+
+void Metrics::collect(Snapshot& out) {
+    out = Snapshot();
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto r = std::memory_order_relaxed;
+    for (const auto& s : shards) {
+        out.requests += s->requests.load(r);
+        out.bytes    += s->bytes.load(r);
+        out.matched  += s->matched.load(r);
+        out.retries  += s->retries.load(r);
+        out.evicted  += s->evicted.load(r);
+        out.inFlight += s->inFlight.load(r);
+        for (unsigned c = 0; c < kCurlCodes; ++c)
+            out.byCurl[c] += s->byCurl[c].load(r);
+        for (unsigned c = 0; c < 6; ++c)
+            out.byClass[c] += s->byClass[c].load(r);
+        for (unsigned l = 0; l < kLatencies; ++l) {
+            for (unsigned b = 0; b < Histogram::kBuckets; ++b)
+                out.latency[l][b] += s->latency[l].counts[b].load(r);
+            out.latencySum[l] += s->latency[l].total.load(r);
+        }
+    }
+}
+
+std::string Metrics::renderPrometheus() {
+    auto snap = std::make_unique<Snapshot>();
+    collect(*snap);
+    const Snapshot& s = *snap;
+    std::string out;
+    out.reserve(16384);
+
+    header(out, "crawler_requests_total", "counter", "Domains processed (final result, retries included).");
+    appendf(out, "crawler_requests_total %llu\n", static_cast<unsigned long long>(s.requests));
+    header(out, "crawler_received_bytes_total", "counter", "Bytes received (CURLINFO_SIZE_DOWNLOAD_T).");
+    appendf(out, "crawler_received_bytes_total %llu\n", static_cast<unsigned long long>(s.bytes));
+    header(out, "crawler_matched_total", "counter", "Domains that matched the keywords/rules.");
+    appendf(out, "crawler_matched_total %llu\n", static_cast<unsigned long long>(s.matched));
+    header(out, "crawler_retries_total", "counter", "Retried attempts.");
+    appendf(out, "crawler_retries_total %llu\n", static_cast<unsigned long long>(s.retries));
+    header(out, "crawler_evicted_total", "counter", "Transfers evicted by deadlines.");
+    appendf(out, "crawler_evicted_total %llu\n", static_cast<unsigned long long>(s.evicted));
+    header(out, "crawler_in_flight", "gauge", "Transfers in flight.");
+    appendf(out, "crawler_in_flight %lld\n", static_cast<long long>(s.inFlight));
+
+    header(out, "crawler_results_total", "counter", "Results by curl result code.");
+    for (unsigned c = 0; c < kCurlCodes; ++c) {
+        if (s.byCurl[c])
+            appendf(out, "crawler_results_total{curl_code=\"%u\"} %llu\n", c,
+                    static_cast<unsigned long long>(s.byCurl[c]));
+    }
+    header(out, "crawler_http_responses_total", "counter", "Results by HTTP status class.");
+    const char* classes[] = {"none", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    for (unsigned c = 0; c < 6; ++c)
+        appendf(out, "crawler_http_responses_total{class=\"%s\"} %llu\n", classes[c],
+                static_cast<unsigned long long>(s.byClass[c]));
+
+    // Корзины гистограмм сворачиваются до степеней двойки: точность HDR остаётся
+    // для квантилей в строке прогресса, а Prometheus получает 20 с небольшим строк на фазу
+    header(out, "crawler_latency_seconds", "histogram", "Phase times from request start (DNS, connect, TLS, first byte, total).");
+    for (unsigned l = 0; l < kLatencies; ++l) {
+        uint64_t cumulative = 0;
+        unsigned b = 0;
+        for (unsigned p = kFirstExportPow; p <= kLastExportPow; ++p) {
+            uint64_t limit = (uint64_t(1) << p) - 1;
+            while (b < Histogram::kBuckets && Histogram::upperBound(b) <= limit)
+                cumulative += s.latency[l][b++];
+            appendf(out, "crawler_latency_seconds_bucket{phase=\"%s\",le=\"%g\"} %llu\n", kLatencyNames[l],
+                    static_cast<double>(uint64_t(1) << p) / 1e6, static_cast<unsigned long long>(cumulative));
+        }
+        while (b < Histogram::kBuckets)
+            cumulative += s.latency[l][b++];
+        appendf(out, "crawler_latency_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n", kLatencyNames[l],
+                static_cast<unsigned long long>(cumulative));
+        appendf(out, "crawler_latency_seconds_sum{phase=\"%s\"} %.6f\n", kLatencyNames[l], s.latencySum[l] / 1e6);
+        appendf(out, "crawler_latency_seconds_count{phase=\"%s\"} %llu\n", kLatencyNames[l],
+                static_cast<unsigned long long>(cumulative));
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& g : gauges) {
+        header(out, g.name.c_str(), "gauge", g.help.c_str());
+        appendf(out, "%s %.17g\n", g.name.c_str(), g.read());
+    }
+    return out;
+}
+
+void Metrics::startProgress(int intervalSec) {
+    if (intervalSec <= 0)
+        return;
+    stopping = false;
+    progressThread = std::thread(&Metrics::progressLoop, intervalSec);
+}
+
+void Metrics::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (progressThread.joinable())
+        progressThread.join();
+}
+
+// Раз в интервал: темп, окно, доля успешных и совпавших, квантили TTFB и общего времени
+void Metrics::progressLoop(int intervalSec) {
+    auto prev = std::make_unique<Snapshot>();
+    auto cur = std::make_unique<Snapshot>();
+    auto last = std::chrono::steady_clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (wakeup.wait_for(lock, std::chrono::seconds(intervalSec), [] { return stopping; }))
+                return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double secs = std::max(1e-3, std::chrono::duration<double>(now - last).count());
+        last = now;
+        collect(*cur);
+
+        uint64_t done = cur->requests - prev->requests;
+        uint64_t ok = cur->byCurl[0] - prev->byCurl[0];
+        uint64_t matched = cur->matched - prev->matched;
+        uint64_t bytes = cur->bytes - prev->bytes;
+        // Квантили — по приросту гистограмм за интервал
+        for (unsigned l = 0; l < kLatencies; ++l) {
+            for (unsigned b = 0; b < Histogram::kBuckets; ++b)
+                prev->latency[l][b] = cur->latency[l][b] - prev->latency[l][b];
+        }
+        Logger::info("Прогресс: %llu доменов (%.0f/с), в полёте %lld, успешно %.1f%%, совпало %.1f%%, %.2f МБ/с, "
+                     "TTFB p50 %s p99 %s, всего p50 %s p99 %s",
+                     static_cast<unsigned long long>(cur->requests), done / secs,
+                     static_cast<long long>(cur->inFlight),
+                     done ? 100.0 * ok / done : 0.0, done ? 100.0 * matched / done : 0.0,
+                     bytes / secs / (1024.0 * 1024.0),
+                     formatUs(prev->quantile(Ttfb, 0.5)).c_str(), formatUs(prev->quantile(Ttfb, 0.99)).c_str(),
+                     formatUs(prev->quantile(Total, 0.5)).c_str(), formatUs(prev->quantile(Total, 0.99)).c_str());
+        std::swap(prev, cur);
+    }
+}
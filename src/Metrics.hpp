@@ -0,0 +1,114 @@
+// src/Metrics.hpp
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "HttpClient.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Метрики прогона. Каждый поток-воркер пишет только в свой Shard: счётчики —
+// атомики, которые меняет единственный владелец (relaxed load + store, без
+// блокирующих инструкций), поэтому горячий путь не делит кэш-линии с другими
+// потоками. Чтение (эндпоинт StatsServer, строка прогресса) складывает все Shard
+// по запросу. Шарды принадлежат реестру и переживают свои потоки.
+class Metrics {
+public:
+    // Гистограмма в духе HDR: 8 линейных подкорзин на каждую степень двойки
+    // (погрешность не больше 12.5%), значения в микросекундах до ~2^40.
+    class Histogram {
+    public:
+        static constexpr unsigned kSubBits = 3;
+        static constexpr unsigned kSub = 1u << kSubBits;
+        static constexpr unsigned kBuckets = (41 - kSubBits) * kSub;
+
+        void record(uint64_t v) {
+            bump(counts[bucketOf(v)], 1);
+            bump(total, v);
+        }
+
+        static unsigned bucketOf(uint64_t v);
+        // Наибольшее значение, попадающее в корзину
+        static uint64_t upperBound(unsigned bucket);
+
+        std::atomic<uint64_t> counts[kBuckets] = {};
+        std::atomic<uint64_t> total{0};
+    };
+
+    enum Latency { Dns, Connect, Tls, Ttfb, Total, kLatencies };
+    static constexpr unsigned kCurlCodes = 100; // CURLcode; большие коды — в последнюю ячейку
+
+    struct Shard {
+        std::atomic<uint64_t> requests{0};   // завершённые домены
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> matched{0};
+        std::atomic<uint64_t> retries{0};
+        std::atomic<uint64_t> evicted{0};
+        std::atomic<int64_t>  inFlight{0};
+        std::atomic<uint64_t> byCurl[kCurlCodes] = {};
+        std::atomic<uint64_t> byClass[6] = {}; // 0 — ответа нет, 1..5 — 1xx..5xx
+        Histogram             latency[kLatencies];
+    };
+
+    // Свёртка всех шардов (обычные числа)
+    struct Snapshot {
+        uint64_t requests = 0, bytes = 0, matched = 0, retries = 0, evicted = 0;
+        int64_t  inFlight = 0;
+        uint64_t byCurl[kCurlCodes] = {};
+        uint64_t byClass[6] = {};
+        uint64_t latency[kLatencies][Histogram::kBuckets] = {};
+        uint64_t latencySum[kLatencies] = {};
+
+        // Квантиль q (0..1) по гистограмме, микросекунды
+        uint64_t quantile(Latency l, double q) const;
+    };
+
+    // Шард текущего потока (создаётся при первом обращении)
+    static Shard& local();
+
+    // Учёт завершённой передачи (вызывается из Worker::handleResponse)
+    static void record(const HttpResponse& resp, bool matched);
+    static void setInFlight(size_t n) { local().inFlight.store(static_cast<int64_t>(n), std::memory_order_relaxed); }
+
+    // Мгновенное значение, вычисляемое при чтении (глубина очереди, занятая память)
+    static void addGauge(const std::string& name, const std::string& help, std::function<double()> read);
+
+    static void collect(Snapshot& out);
+
+    // Текст в формате Prometheus (text exposition 0.0.4)
+    static std::string renderPrometheus();
+
+    // Строка прогресса в лог раз в intervalSec секунд (0 — не выводить)
+    static void startProgress(int intervalSec);
+    static void stop();
+
+private:
+    struct Gauge {
+        std::string name;
+        std::string help;
+        std::function<double()> read;
+    };
+
+    // Единственный писатель: инкремент без lock-префикса
+    static void bump(std::atomic<uint64_t>& c, uint64_t by) {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    static void progressLoop(int intervalSec);
+
+    static std::mutex mtx; // реестр шардов и показателей
+    static std::vector<std::unique_ptr<Shard>> shards;
+    static std::vector<Gauge> gauges;
+    static std::thread progressThread;
+    static std::condition_variable wakeup;
+    static bool stopping;
+};
+
+#endif // METRICS_HPP
@@ -0,0 +1,238 @@
+// src/RangeCoordinator.cpp
+#include "RangeCoordinator.hpp"
+#include "Logger.hpp"
+#include "MappedInput.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// "[host:]port" -> host, port; host по умолчанию — defaultHost
+bool splitAddress(const std::string& address, const char* defaultHost, std::string& host, std::string& port) {
+    size_t colon = address.rfind(':');
+    host = colon == std::string::npos ? defaultHost : address.substr(0, colon);
+    port = colon == std::string::npos ? address : address.substr(colon + 1);
+    int p = std::atoi(port.c_str());
+    return !host.empty() && p > 0 && p <= 65535 && port.find_first_not_of("0123456789") == std::string::npos;
+}
+
+bool sendAll(int fd, const char* data, size_t len, int flags = 0) {
+    while (len) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL | flags);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+struct Peer {
+    int         fd = -1;
+    std::string name;
+    std::string in;
+    size_t      chunks = 0;
+    size_t      bytes = 0;
+};
+
+} // namespace
+
+int RangeCoordinator::serve(const std::string& inputPath, const std::string& address, size_t chunkLines) {
+    MappedInput input;
+    if (!input.open(inputPath))
+        return 1;
+    std::string host, port;
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    if (!splitAddress(address, "127.0.0.1", host, port) || inet_pton(AF_INET, host.c_str(), &sa.sin_addr) != 1) {
+        Logger::error("Invalid coordinator address: %s (expected [ip:]port)", address.c_str());
+        return 1;
+    }
+    sa.sin_port = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+    int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 || listen(listenFd, 64) != 0) {
+        Logger::error("Coordinator: cannot listen on %s:%s: %s", host.c_str(), port.c_str(), std::strerror(errno));
+        close(listenFd);
+        return 1;
+    }
+    Logger::info("Координатор: %s (%zu байт), куски по %zu строк, адрес %s:%s",
+                 inputPath.c_str(), input.size(), chunkLines, host.c_str(), port.c_str());
+
+    const char* base = input.data();
+    const size_t size = input.size();
+    size_t pos = 0, chunksTotal = 0, peersTotal = 0;
+    std::vector<Peer> peers;
+    std::vector<pollfd> fds;
+
+    // Работаем, пока есть что раздавать или кто-то ещё не получил DONE
+    while (pos < size || !peers.empty()) {
+        fds.assign(1, pollfd{listenFd, POLLIN, 0});
+        for (const Peer& p : peers)
+            fds.push_back(pollfd{p.fd, POLLIN, 0});
+        if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR)
+            break;
+
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in from{};
+            socklen_t len = sizeof(from);
+            int fd = accept4(listenFd, reinterpret_cast<sockaddr*>(&from), &len, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                // Зависший узел не должен останавливать раздачу остальным
+                timeval tv{10, 0};
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+                char ip[INET_ADDRSTRLEN] = "?";
+                inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+                Peer p;
+                p.fd = fd;
+                p.name = std::string(ip) + ":" + std::to_string(ntohs(from.sin_port));
+                peers.push_back(std::move(p));
+                ++peersTotal;
+            }
+        }
+
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (!fds[i].revents)
+                continue;
+            Peer& p = peers[i - 1];
+            char buf[256];
+            ssize_t n = recv(p.fd, buf, sizeof(buf), 0);
+            bool alive = n > 0;
+            if (alive)
+                p.in.append(buf, static_cast<size_t>(n));
+            size_t eol;
+            while (alive && (eol = p.in.find('\n')) != std::string::npos) {
+                std::string cmd = p.in.substr(0, eol);
+                p.in.erase(0, eol + 1);
+                if (cmd != "NEXT") {
+                    alive = false;
+                    break;
+                }
+                if (pos >= size) {
+                    sendAll(p.fd, "DONE\n", 5);
+                    alive = false;
+                    break;
+                }
+                // Кусок — chunkLines строк от текущей позиции
+                size_t end = pos;
+                for (size_t lines = 0; lines < chunkLines && end < size; ++lines) {
+                    const void* nl = std::memchr(base + end, '\n', size - end);
+                    end = nl ? static_cast<size_t>(static_cast<const char*>(nl) - base) + 1 : size;
+                }
+                std::string header = "CHUNK " + std::to_string(end - pos) + "\n";
+                alive = sendAll(p.fd, header.data(), header.size(), MSG_MORE) &&
+                        sendAll(p.fd, base + pos, end - pos);
+                if (alive) {
+                    ++p.chunks;
+                    p.bytes += end - pos;
+                    ++chunksTotal;
+                    pos = end;
+                }
+            }
+            if (!alive)
+                p.fd = -p.fd - 1; // закрывается ниже, после обхода
+        }
+
+        for (size_t i = 0; i < peers.size();) {
+            if (peers[i].fd >= 0) {
+                ++i;
+                continue;
+            }
+            close(-peers[i].fd - 1);
+            Logger::info("Координатор: узел %s отключился, выдано кусков %zu (%zu байт)",
+                         peers[i].name.c_str(), peers[i].chunks, peers[i].bytes);
+            peers.erase(peers.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+    close(listenFd);
+    Logger::info("Координатор: вход роздан, кусков %zu, узлов %zu", chunksTotal, peersTotal);
+    return 0;
+}
+
+RangeCoordinator::Client::~Client() {
+    if (fd >= 0)
+        close(fd);
+}
+
+bool RangeCoordinator::Client::connect(const std::string& address) {
+    std::string host, port;
+    if (!splitAddress(address, "127.0.0.1", host, port)) {
+        Logger::error("Invalid coordinator address: %s (expected [host:]port)", address.c_str());
+        return false;
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+    if (rc != 0) {
+        Logger::error("Coordinator %s: %s", address.c_str(), gai_strerror(rc));
+        return false;
+    }
+    for (addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd >= 0 && ::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0) {
+        Logger::error("Cannot connect to coordinator %s: %s", address.c_str(), std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool RangeCoordinator::Client::readLine(std::string& line) {
+    size_t eol;
+    while ((eol = buffer.find('\n')) == std::string::npos) {
+        char buf[4096];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buffer.append(buf, static_cast<size_t>(n));
+    }
+    line.assign(buffer, 0, eol);
+    buffer.erase(0, eol + 1);
+    return true;
+}
+
+bool RangeCoordinator::Client::next(std::string& chunk) {
+    chunk.clear();
+    std::string header;
+    if (fd < 0 || !sendAll(fd, "NEXT\n", 5) || !readLine(header))
+        return false;
+    if (header == "DONE" || header.rfind("CHUNK ", 0) != 0)
+        return false;
+    size_t len = static_cast<size_t>(std::strtoull(header.c_str() + 6, nullptr, 10));
+    size_t have = std::min(len, buffer.size());
+    chunk.assign(buffer, 0, have);
+    buffer.erase(0, have);
+    chunk.resize(len);
+    while (have < len) {
+        ssize_t n = recv(fd, &chunk[have], len - have, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            Logger::error("Coordinator connection lost in the middle of a chunk");
+            return false;
+        }
+        have += static_cast<size_t>(n);
+    }
+    return true;
+}
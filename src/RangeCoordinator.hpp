@@ -0,0 +1,45 @@
+// src/RangeCoordinator.hpp
+#ifndef RANGECOORDINATOR_HPP
+#define RANGECOORDINATOR_HPP
+
+#include <cstddef>
+#include <string>
+
+// Координатор раздачи входа между узлами (work stealing). Входной файл отображается
+// в память и раздаётся кусками по chunkLines строк тому узлу, который попросил:
+// быстрый узел забирает больше, медленный — меньше, поэтому узлы, которым достались
+// медленные или мёртвые хосты, не задерживают остальных.
+//
+// Протокол (TCP, текстовые заголовки):
+//   узел:        "NEXT\n"
+//   координатор: "CHUNK <байт>\n" + строки куска | "DONE\n" — вход исчерпан
+//
+// Координатор однопоточный (poll) и завершается, когда вход роздан и все узлы
+// получили DONE. Кусок, выданный узлу, который потом упал, повторно не раздаётся —
+// его домены отсутствуют в слитом результате и догоняются отдельным прогоном.
+class RangeCoordinator {
+public:
+    // address — "[ip:]port" (по умолчанию 127.0.0.1); возвращает код выхода
+    static int serve(const std::string& inputPath, const std::string& address, size_t chunkLines);
+
+    // Сторона узла (DomainLoader, --pull=host:port)
+    class Client {
+    public:
+        Client() = default;
+        ~Client();
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        bool connect(const std::string& address);
+        // Следующий кусок; false — вход исчерпан или связь потеряна
+        bool next(std::string& chunk);
+
+    private:
+        bool readLine(std::string& line);
+
+        int         fd = -1;
+        std::string buffer; // принятые, ещё не разобранные байты
+    };
+};
+
+#endif // RANGECOORDINATOR_HPP
@@ -0,0 +1,267 @@
+// src/ResultFormat.cpp
+#include "ResultFormat.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+const char* const kCsvHeader =
+    "domain,http_code,curl_code,effective_url,bytes,dns_us,connect_us,tls_us,ttfb_us,total_us,retries,evicted,truncated,matched,keywords,rules\n";
+
+// id сработавших правил через sep
+void appendRuleIds(std::string& out, const HttpResponse& resp, char sep) {
+    if (!resp.rules)
+        return;
+    bool first = true;
+    for (size_t r = 0; r < resp.rules->size(); ++r) {
+        if (resp.rules->matched(resp.ruleState, r)) {
+            if (!first)
+                out.push_back(sep);
+            out += resp.rules->id(r);
+            first = false;
+        }
+    }
+}
+
+bool wordFound(const KeywordMatcher::State& st, size_t w) {
+    return w / 64 < st.found.size() && (st.found[w / 64] >> (w % 64)) & 1;
+}
+
+void appendCsvField(std::string& out, std::string_view v) {
+    if (v.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(v.data(), v.size());
+        return;
+    }
+    out.push_back('"');
+    for (char c : v) {
+        if (c == '"')
+            out.push_back('"');
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+void appendJsonString(std::string& out, std::string_view v) {
+    out.push_back('"');
+    for (unsigned char c : v) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out.push_back(static_cast<char>(c));
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+void appendNumber(std::string& out, long long v) {
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "%lld", v);
+    out.append(buf, static_cast<size_t>(n));
+}
+
+template <typename T>
+void appendLE(std::string& out, T v) {
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out.push_back(static_cast<char>((static_cast<uint64_t>(v) >> (8 * i)) & 0xFF));
+}
+
+void appendShortString(std::string& out, std::string_view v) {
+    size_t len = std::min<size_t>(v.size(), 0xFFFF);
+    appendLE<uint16_t>(out, static_cast<uint16_t>(len));
+    out.append(v.data(), len);
+}
+
+const char* evictionName(Eviction e) {
+    switch (e) {
+    case Eviction::Connect:   return "connect";
+    case Eviction::Tls:       return "tls";
+    case Eviction::FirstByte: return "first_byte";
+    case Eviction::Total:     return "total";
+    case Eviction::LowSpeed:  return "low_speed";
+    default:                  return "";
+    }
+}
+
+uint32_t clampUs(curl_off_t v) {
+    return static_cast<uint32_t>(std::max<curl_off_t>(0, std::min<curl_off_t>(v, UINT32_MAX)));
+}
+
+} // namespace
+
+bool ResultFormat::parse(const std::string& name, Format& out) {
+    if (name == "plain")  { out = Format::Plain;  return true; }
+    if (name == "csv")    { out = Format::Csv;    return true; }
+    if (name == "ndjson") { out = Format::Ndjson; return true; }
+    if (name == "binary") { out = Format::Binary; return true; }
+    return false;
+}
+
+std::string ResultFormat::header(Format f, const KeywordMatcher& matcher, const RuleSet* rules) {
+    std::string out;
+    if (f == Format::Csv) {
+        out = kCsvHeader;
+    } else if (f == Format::Binary) {
+        out = "FCR2";
+        const auto& words = matcher.words();
+        appendLE<uint16_t>(out, static_cast<uint16_t>(words.size()));
+        for (const auto& w : words)
+            appendShortString(out, w);
+        size_t n = rules ? std::min<size_t>(rules->size(), 0xFFFF) : 0;
+        appendLE<uint16_t>(out, static_cast<uint16_t>(n));
+        for (size_t r = 0; r < n; ++r)
+            appendShortString(out, rules->id(r));
+    }
+    return out;
+}
+
+void ResultFormat::append(Format f, std::string_view domain, const HttpResponse& resp,
+                          const KeywordMatcher& matcher, bool matched, std::string& out) {
+    const auto& words = matcher.words();
+    const TransferTimings& tm = resp.timings;
+
+    switch (f) {
+    case Format::Plain:
+        if (matched) {
+            out.append(domain.data(), domain.size());
+            if (resp.rules) {
+                out.push_back('\t');
+                appendRuleIds(out, resp, ',');
+            }
+            out.push_back('\n');
+        }
+        break;
+
+    case Format::Csv: {
+        appendCsvField(out, domain);
+        out.push_back(',');
+        appendNumber(out, resp.code);
+        out.push_back(',');
+        appendNumber(out, resp.result);
+        out.push_back(',');
+        appendCsvField(out, resp.effectiveUrl);
+        for (curl_off_t v : {resp.bytesReceived, tm.dns, tm.connect, tm.tls, tm.ttfb, tm.total}) {
+            out.push_back(',');
+            appendNumber(out, v);
+        }
+        out.push_back(',');
+        appendNumber(out, resp.retries);
+        out.push_back(',');
+        out += evictionName(resp.evicted);
+        out += resp.truncated ? ",1" : ",0";
+        out += matched ? ",1," : ",0,";
+        // Найденные слова через ';'
+        std::string found;
+        for (size_t w = 0; w < words.size(); ++w) {
+            if (wordFound(resp.matchState, w)) {
+                if (!found.empty())
+                    found.push_back(';');
+                found += words[w];
+            }
+        }
+        appendCsvField(out, found);
+        out.push_back(',');
+        appendRuleIds(out, resp, ';');
+        out.push_back('\n');
+        break;
+    }
+
+    case Format::Ndjson: {
+        out += "{\"domain\":";
+        appendJsonString(out, domain);
+        out += ",\"http_code\":";
+        appendNumber(out, resp.code);
+        out += ",\"curl_code\":";
+        appendNumber(out, resp.result);
+        out += ",\"effective_url\":";
+        appendJsonString(out, resp.effectiveUrl);
+        out += ",\"bytes\":";
+        appendNumber(out, resp.bytesReceived);
+        out += ",\"dns_us\":";
+        appendNumber(out, tm.dns);
+        out += ",\"connect_us\":";
+        appendNumber(out, tm.connect);
+        out += ",\"tls_us\":";
+        appendNumber(out, tm.tls);
+        out += ",\"ttfb_us\":";
+        appendNumber(out, tm.ttfb);
+        out += ",\"total_us\":";
+        appendNumber(out, tm.total);
+        out += ",\"retries\":";
+        appendNumber(out, resp.retries);
+        out += ",\"evicted\":";
+        if (resp.evicted == Eviction::None)
+            out += "null";
+        else
+            appendJsonString(out, evictionName(resp.evicted));
+        out += resp.truncated ? ",\"truncated\":true" : ",\"truncated\":false";
+        out += matched ? ",\"matched\":true,\"keywords\":[" : ",\"matched\":false,\"keywords\":[";
+        bool first = true;
+        for (size_t w = 0; w < words.size(); ++w) {
+            if (wordFound(resp.matchState, w)) {
+                if (!first)
+                    out.push_back(',');
+                appendJsonString(out, words[w]);
+                first = false;
+            }
+        }
+        out += "],\"rules\":[";
+        first = true;
+        if (resp.rules) {
+            for (size_t r = 0; r < resp.rules->size(); ++r) {
+                if (resp.rules->matched(resp.ruleState, r)) {
+                    if (!first)
+                        out.push_back(',');
+                    appendJsonString(out, resp.rules->id(r));
+                    first = false;
+                }
+            }
+        }
+        out += "]}\n";
+        break;
+    }
+
+    case Format::Binary: {
+        size_t start = out.size();
+        appendLE<uint32_t>(out, 0); // длина, заполняется ниже
+        appendLE<int16_t>(out, static_cast<int16_t>(resp.code));
+        appendLE<uint16_t>(out, static_cast<uint16_t>(resp.result));
+        appendLE<uint8_t>(out, (matched ? 1 : 0) | (resp.truncated ? 2 : 0));
+        appendLE<uint8_t>(out, static_cast<uint8_t>(std::min(resp.retries, 255)));
+        appendLE<uint8_t>(out, static_cast<uint8_t>(resp.evicted));
+        appendLE<uint64_t>(out, static_cast<uint64_t>(std::max<curl_off_t>(resp.bytesReceived, 0)));
+        for (curl_off_t v : {tm.dns, tm.connect, tm.tls, tm.ttfb, tm.total})
+            appendLE<uint32_t>(out, clampUs(v));
+        appendLE<uint64_t>(out, resp.matchState.found.empty() ? 0 : resp.matchState.found[0]);
+        appendShortString(out, domain);
+        appendShortString(out, resp.effectiveUrl);
+        size_t countAt = out.size();
+        uint16_t count = 0;
+        appendLE<uint16_t>(out, 0);
+        if (resp.rules) {
+            for (size_t r = 0; r < resp.rules->size() && r <= 0xFFFF; ++r) {
+                if (resp.rules->matched(resp.ruleState, r)) {
+                    appendLE<uint16_t>(out, static_cast<uint16_t>(r));
+                    ++count;
+                }
+            }
+        }
+        out[countAt] = static_cast<char>(count & 0xFF);
+        out[countAt + 1] = static_cast<char>(count >> 8);
+        uint32_t len = static_cast<uint32_t>(out.size() - start - 4);
+        for (size_t i = 0; i < 4; ++i)
+            out[start + i] = static_cast<char>((len >> (8 * i)) & 0xFF);
+        break;
+    }
+    }
+}
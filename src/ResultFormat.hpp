@@ -0,0 +1,40 @@
+// src/ResultFormat.hpp
+#ifndef RESULTFORMAT_HPP
+#define RESULTFORMAT_HPP
+
+#include "HttpClient.hpp"
+#include "KeywordMatcher.hpp"
+#include "RuleSet.hpp"
+#include <string>
+#include <string_view>
+
+// Форматы файла результатов (--format=...):
+//   Plain  — только совпавшие домены, по одному в строке (с --rules — и id сработавших правил через таб);
+//   Csv    — все домены: статус, код curl, итоговый URL, байты, времена фаз, повторы, снятие по сроку,
+//            обрезку по --max-bytes, найденные слова, сработавшие правила;
+//   Ndjson — то же, по JSON-объекту в строке;
+//   Binary — компактные записи фиксированной структуры для очень больших прогонов.
+//
+// Binary: заголовок "FCR2", uint16 число слов, затем слова (uint16 длина + байты),
+// uint16 число правил, затем id правил (uint16 длина + байты).
+// Запись (little-endian): uint32 длина остатка записи, int16 HTTP-код, uint16 код curl,
+// uint8 флаги (bit0 — совпадение, bit1 — тело обрезано по --max-bytes), uint8 число повторов,
+// uint8 причина снятия по сроку (Eviction), uint64 байт, 5 x uint32 времени фаз (мкс),
+// uint64 маска найденных слов (первые 64), uint16 длина + домен, uint16 длина + итоговый URL,
+// uint16 число сработавших правил, затем их номера (uint16).
+class ResultFormat {
+public:
+    enum class Format { Plain, Csv, Ndjson, Binary };
+
+    static bool parse(const std::string& name, Format& out);
+
+    // Заголовок файла (может быть пустым)
+    static std::string header(Format f, const KeywordMatcher& matcher, const RuleSet* rules);
+
+    // Дописывает запись в out. Для Plain несовпавшие домены пропускаются.
+    // Сработавшие правила берутся из resp.rules / resp.ruleState.
+    static void append(Format f, std::string_view domain, const HttpResponse& resp,
+                       const KeywordMatcher& matcher, bool matched, std::string& out);
+};
+
+#endif // RESULTFORMAT_HPP
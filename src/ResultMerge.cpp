@@ -0,0 +1,283 @@
+// src/ResultMerge.cpp
+#include "ResultMerge.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <string_view>
+#include <unistd.h>
+
+namespace {
+
+enum class Kind { None, Csv, Ndjson, Plain };
+
+const char* const kNdjsonPrefix = "{\"domain\":";
+const size_t kNdjsonPrefixLen = 10;
+const size_t kIoBuffer = 1u << 20;
+
+struct FileCloser {
+    void operator()(FILE* f) const { std::fclose(f); }
+};
+using File = std::unique_ptr<FILE, FileCloser>;
+
+// Построчное чтение без копирования: строка живёт до следующего next()
+class LineReader {
+public:
+    explicit LineReader(FILE* f = nullptr) : file(f) {}
+    ~LineReader() { std::free(buf); }
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    // Следующая непустая строка без \r\n
+    bool next(std::string_view& line) {
+        ssize_t n;
+        while ((n = getline(&buf, &cap, file)) >= 0) {
+            while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == '\r'))
+                --n;
+            if (n > 0) {
+                line = std::string_view(buf, static_cast<size_t>(n));
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    FILE*  file;
+    char*  buf = nullptr;
+    size_t cap = 0;
+};
+
+Kind detect(std::string_view first) {
+    if (first.rfind("FCR", 0) == 0)
+        return Kind::None;
+    if (first.rfind("domain,", 0) == 0)
+        return Kind::Csv;
+    if (first.rfind(kNdjsonPrefix, 0) == 0)
+        return Kind::Ndjson;
+    return Kind::Plain;
+}
+
+// Ключ слияния — поле домена в том виде, как его записал узел (кавычки и
+// экранирование у всех узлов одинаковые, разбирать их не нужно)
+std::string_view keyOf(Kind kind, std::string_view line) {
+    if (kind == Kind::Csv) {
+        if (line.empty() || line[0] != '"')
+            return line.substr(0, line.find(','));
+        for (size_t i = 1; i < line.size(); ++i) {
+            if (line[i] != '"')
+                continue;
+            if (i + 1 < line.size() && line[i + 1] == '"')
+                ++i;
+            else
+                return line.substr(0, i + 1);
+        }
+        return line;
+    }
+    if (kind == Kind::Ndjson) {
+        if (line.rfind(kNdjsonPrefix, 0) != 0 || line.size() <= kNdjsonPrefixLen)
+            return line;
+        size_t i = kNdjsonPrefixLen + 1;
+        while (i < line.size() && line[i] != '"')
+            i += line[i] == '\\' ? 2 : 1;
+        return line.substr(kNdjsonPrefixLen, std::min(i + 1, line.size()) - kNdjsonPrefixLen);
+    }
+    return line.substr(0, line.find('\t'));
+}
+
+// Отсортированный прогон копится в одном буфере; записи — смещения в нём
+struct Record {
+    size_t   offset;
+    uint32_t length;
+    uint32_t keyOffset;
+    uint32_t keyLength;
+};
+
+class RunBuilder {
+public:
+    RunBuilder(const std::string& dir, size_t memoryBytes) : dir(dir), limit(memoryBytes) {
+        arena.reserve(limit);
+    }
+
+    bool add(Kind kind, std::string_view line, std::vector<File>& runs) {
+        std::string_view key = keyOf(kind, line);
+        records.push_back(Record{arena.size(), static_cast<uint32_t>(line.size()),
+                                 static_cast<uint32_t>(key.data() - line.data()),
+                                 static_cast<uint32_t>(key.size())});
+        arena.append(line.data(), line.size());
+        if (arena.size() + records.size() * sizeof(Record) < limit)
+            return true;
+        return flush(runs);
+    }
+
+    // Сортирует накопленное и сбрасывает во временный файл
+    bool flush(std::vector<File>& runs) {
+        if (records.empty())
+            return true;
+        auto key = [this](const Record& r) {
+            return std::string_view(arena.data() + r.offset + r.keyOffset, r.keyLength);
+        };
+        // stable — при равных ключах сохраняется порядок внутри входа
+        std::stable_sort(records.begin(), records.end(),
+                         [&](const Record& a, const Record& b) { return key(a) < key(b); });
+
+        std::string path = dir + "/.merge-run.XXXXXX";
+        int fd = mkstemp(&path[0]);
+        if (fd < 0) {
+            Logger::error("Merge: cannot create temporary file in %s: %s", dir.c_str(), std::strerror(errno));
+            return false;
+        }
+        unlink(path.c_str());
+        File f(fdopen(fd, "w+"));
+        std::setvbuf(f.get(), nullptr, _IOFBF, kIoBuffer);
+        for (const Record& r : records) {
+            std::fwrite(arena.data() + r.offset, 1, r.length, f.get());
+            std::fputc('\n', f.get());
+        }
+        if (std::fflush(f.get()) != 0 || std::ferror(f.get())) {
+            Logger::error("Merge: cannot write temporary file in %s: %s", dir.c_str(), std::strerror(errno));
+            return false;
+        }
+        std::rewind(f.get());
+        runs.push_back(std::move(f));
+        records.clear();
+        arena.clear();
+        return true;
+    }
+
+private:
+    std::string         dir;
+    size_t              limit;
+    std::string         arena;
+    std::vector<Record> records;
+};
+
+} // namespace
+
+bool ResultMerge::merge(const std::vector<std::string>& inputs, const std::string& output,
+                        const Settings& settings, Stats& stats) {
+    std::string dir = settings.tempDir;
+    if (dir.empty()) {
+        size_t slash = output.rfind('/');
+        dir = slash == std::string::npos ? "." : slash == 0 ? "/" : output.substr(0, slash);
+    }
+
+    // Фаза 1: входы -> отсортированные прогоны
+    Kind kind = Kind::None;
+    std::string csvHeader;
+    std::vector<File> runs;
+    RunBuilder builder(dir, std::max<size_t>(settings.memoryBytes, 1u << 20));
+    for (const std::string& path : inputs) {
+        if (path == output) {
+            Logger::error("Merge: output file %s is also an input", output.c_str());
+            return false;
+        }
+        File in(std::fopen(path.c_str(), "rb"));
+        if (!in) {
+            Logger::error("Merge: cannot open %s: %s", path.c_str(), std::strerror(errno));
+            return false;
+        }
+        std::setvbuf(in.get(), nullptr, _IOFBF, kIoBuffer);
+        LineReader reader(in.get());
+        std::string_view line;
+        if (!reader.next(line))
+            continue; // пустой вход
+        Kind k = detect(line);
+        if (k == Kind::None) {
+            Logger::error("Merge: %s is a binary result file; merge supports csv, ndjson and plain", path.c_str());
+            return false;
+        }
+        if (kind != Kind::None && k != kind) {
+            Logger::error("Merge: %s has a different format than the previous inputs", path.c_str());
+            return false;
+        }
+        kind = k;
+        if (kind == Kind::Csv) {
+            // Набор колонок зависит от --contains/--rules узла: разные заголовки не сливаются
+            if (csvHeader.empty()) {
+                csvHeader.assign(line.data(), line.size());
+            } else if (line != csvHeader) {
+                Logger::error("Merge: %s has a different CSV header", path.c_str());
+                return false;
+            }
+            if (!reader.next(line))
+                continue;
+        }
+        do {
+            if (!builder.add(kind, line, runs))
+                return false;
+        } while (reader.next(line));
+        if (std::ferror(in.get())) {
+            Logger::error("Merge: read error in %s", path.c_str());
+            return false;
+        }
+        // Прогон не смешивает входы: порядок прогонов = порядок входов
+        if (!builder.flush(runs))
+            return false;
+    }
+    stats.runs = runs.size();
+
+    // Фаза 2: k-путевое слияние прогонов
+    File out(std::fopen(output.c_str(), "wb"));
+    if (!out) {
+        Logger::error("Merge: cannot open %s: %s", output.c_str(), std::strerror(errno));
+        return false;
+    }
+    std::setvbuf(out.get(), nullptr, _IOFBF, kIoBuffer);
+    if (!csvHeader.empty()) {
+        std::fwrite(csvHeader.data(), 1, csvHeader.size(), out.get());
+        std::fputc('\n', out.get());
+    }
+
+    struct Source {
+        std::unique_ptr<LineReader> reader;
+        std::string_view            line;
+        std::string_view            key;
+    };
+    std::vector<Source> sources(runs.size());
+    // Вершина — наименьший ключ; при равных — более ранний прогон
+    auto after = [&](size_t a, size_t b) {
+        int c = sources[a].key.compare(sources[b].key);
+        return c != 0 ? c > 0 : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        Source& s = sources[i];
+        s.reader = std::make_unique<LineReader>(runs[i].get());
+        if (s.reader->next(s.line)) {
+            s.key = keyOf(kind, s.line);
+            heap.push(i);
+        }
+    }
+
+    std::string lastKey;
+    bool haveLast = false;
+    while (!heap.empty()) {
+        size_t i = heap.top();
+        heap.pop();
+        Source& s = sources[i];
+        if (!settings.keepDuplicates && haveLast && s.key == lastKey) {
+            ++stats.duplicates;
+        } else {
+            std::fwrite(s.line.data(), 1, s.line.size(), out.get());
+            std::fputc('\n', out.get());
+            ++stats.records;
+            lastKey.assign(s.key.data(), s.key.size());
+            haveLast = true;
+        }
+        if (s.reader->next(s.line)) {
+            s.key = keyOf(kind, s.line);
+            heap.push(i);
+        }
+    }
+
+    if (std::fflush(out.get()) != 0 || std::ferror(out.get())) {
+        Logger::error("Merge: write error in %s: %s", output.c_str(), std::strerror(errno));
+        return false;
+    }
+    return true;
+}
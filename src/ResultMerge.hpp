@@ -0,0 +1,39 @@
+// src/ResultMerge.hpp
+#ifndef RESULTMERGE_HPP
+#define RESULTMERGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Слияние файлов результатов нескольких узлов в один, упорядоченный по домену.
+// Узлы пишут результаты в порядке завершения запросов, поэтому каждый вход сначала
+// режется на отсортированные прогоны в пределах memoryBytes (прогоны — во временных
+// файлах, удаляются сразу после создания), затем все прогоны сливаются потоково
+// через кучу: память не зависит от размера входов, каждый байт читается дважды.
+//
+// Формат определяется по первой строке: csv (заголовок "domain,"), ndjson
+// ({"domain":...}) или plain (домен до табуляции). Входы одного слияния — одного
+// формата; binary не поддерживается. Заголовок CSV пишется один раз.
+// Один домен в нескольких входах (повторный прогон, пересечение узлов вручную
+// разрезанного списка) оставляется один раз — из входа, указанного раньше.
+class ResultMerge {
+public:
+    struct Settings {
+        size_t      memoryBytes = 256u << 20; // на один отсортированный прогон
+        bool        keepDuplicates = false;
+        std::string tempDir;                  // пусто — каталог выходного файла
+    };
+
+    struct Stats {
+        uint64_t records = 0;    // записано
+        uint64_t duplicates = 0; // отброшено повторов домена
+        size_t   runs = 0;
+    };
+
+    static bool merge(const std::vector<std::string>& inputs, const std::string& output,
+                      const Settings& settings, Stats& stats);
+};
+
+#endif // RESULTMERGE_HPP
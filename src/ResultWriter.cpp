@@ -0,0 +1,220 @@
+// src/ResultWriter.cpp
+#include "ResultWriter.hpp"
+#include "Logger.hpp"
+#include "MemoryBudget.hpp"
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+namespace {
+// При таком объёме буфера потока писатель будится досрочно
+constexpr size_t kWakeBytes = 1 << 20;
+// Блоки крупнее не возвращаются потоку, а освобождаются
+constexpr size_t kRetainBytes = 4 << 20;
+}
+
+int                      ResultWriter::fd = -1;
+int                      ResultWriter::journalFd = -1;
+int                      ResultWriter::flushMs = 1000;
+bool                     ResultWriter::syncData = false;
+bool                     ResultWriter::stopping = false;
+std::thread              ResultWriter::writerThread;
+std::mutex               ResultWriter::mtx;
+std::condition_variable  ResultWriter::wakeup;
+std::vector<std::unique_ptr<ResultWriter::Buffer>> ResultWriter::buffers;
+
+void ResultWriter::start(int fd_, int flushMs_, bool syncData_, const std::string& header) {
+    fd = fd_;
+    flushMs = std::max(flushMs_, 1);
+    syncData = syncData_;
+    stopping = false;
+    if (!header.empty())
+        writeAll(header.data(), header.size());
+    writerThread = std::thread(&ResultWriter::run);
+}
+
+void ResultWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (writerThread.joinable())
+        writerThread.join();
+}
+
+ResultWriter::Buffer& ResultWriter::localBuffer() {
+    // Буфер принадлежит писателю и переживает поток, который его создал
+    thread_local Buffer* local = nullptr;
+    if (!local) {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.push_back(std::make_unique<Buffer>());
+        local = buffers.back().get();
+    }
+    return *local;
+}
+
+bool ResultWriter::writeAll(const char* data, size_t len) {
+    while (len) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            Logger::error("ResultWriter: ошибка записи результатов: %s", std::strerror(errno));
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void ResultWriter::writeLine(std::string_view line) {
+    Buffer& buf = localBuffer();
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(buf.mtx);
+        buf.data.append(line.data(), line.size());
+        buf.data.push_back('\n');
+        pending = buf.data.size();
+    }
+    MemoryBudget::acquire(line.size() + 1);
+    if (pending >= kWakeBytes)
+        wakeup.notify_one();
+}
+
+void ResultWriter::write(std::string_view data) {
+    Buffer& buf = localBuffer();
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(buf.mtx);
+        buf.data.append(data.data(), data.size());
+        pending = buf.data.size();
+    }
+    MemoryBudget::acquire(data.size());
+    if (pending >= kWakeBytes)
+        wakeup.notify_one();
+}
+
+void ResultWriter::setJournal(int fd_) {
+    journalFd = fd_;
+}
+
+void ResultWriter::markDone(uint64_t fingerprint) {
+    char rec[sizeof(uint64_t)];
+    for (size_t b = 0; b < sizeof(rec); ++b)
+        rec[b] = static_cast<char>(fingerprint >> (8 * b));
+    Buffer& buf = localBuffer();
+    std::lock_guard<std::mutex> lock(buf.mtx);
+    buf.journal.append(rec, sizeof(rec));
+}
+
+void ResultWriter::drain() {
+    // Забираем накопленное из всех буферов, подменяя их пустыми строками.
+    // Результаты и журнал забираются под одним захватом, чтобы отметка о домене
+    // не опередила его результат.
+    // Буфер потока меняется местами с запасным (уже выделенным) блоком,
+    // а записанный блок потом возвращается в запас — без аллокаций на каждый сброс.
+    std::vector<std::string> blocks;
+    std::vector<Buffer*> owners;
+    std::vector<std::string> journal;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        blocks.reserve(buffers.size());
+        owners.reserve(buffers.size());
+        for (auto& b : buffers) {
+            std::string taken, takenJournal;
+            {
+                std::lock_guard<std::mutex> bl(b->mtx);
+                if (!b->data.empty()) {
+                    taken.swap(b->data);
+                    b->data.swap(b->spare);
+                }
+                takenJournal.swap(b->journal);
+            }
+            if (!taken.empty()) {
+                blocks.push_back(std::move(taken));
+                owners.push_back(b.get());
+            }
+            if (!takenJournal.empty())
+                journal.push_back(std::move(takenJournal));
+        }
+    }
+
+    if (!blocks.empty()) {
+        bool ok = writeBlocks(fd, blocks);
+        recycleBlocks(owners, blocks);
+        if (!ok)
+            return; // без результатов журнал не пишем
+        // При --fsync результаты сбрасываются на диск раньше журнала
+        if (syncData)
+            ::fdatasync(fd);
+    }
+    if (journalFd >= 0 && !journal.empty()) {
+        if (writeBlocks(journalFd, journal) && syncData)
+            ::fdatasync(journalFd);
+    }
+}
+
+// Возвращает записанные блоки потокам-владельцам как запасные буферы
+void ResultWriter::recycleBlocks(std::vector<Buffer*>& owners, std::vector<std::string>& blocks) {
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        std::string& block = blocks[i];
+        MemoryBudget::release(block.size());
+        if (block.capacity() > kRetainBytes)
+            continue;
+        block.clear();
+        std::lock_guard<std::mutex> bl(owners[i]->mtx);
+        if (owners[i]->spare.capacity() < block.capacity())
+            owners[i]->spare.swap(block);
+    }
+}
+
+bool ResultWriter::writeBlocks(int out, std::vector<std::string>& blocks) {
+    std::vector<iovec> iov;
+    iov.reserve(blocks.size());
+    for (auto& b : blocks)
+        iov.push_back(iovec{&b[0], b.size()});
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t n = ::writev(out, &iov[first], count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            Logger::error("ResultWriter: ошибка записи результатов: %s", std::strerror(errno));
+            return false;
+        }
+        // Продвигаемся по iovec с учётом частичной записи
+        size_t written = static_cast<size_t>(n);
+        while (first < iov.size() && written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < iov.size() && written) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+void ResultWriter::run() {
+    while (true) {
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (!stopping)
+                wakeup.wait_for(lock, std::chrono::milliseconds(flushMs));
+            last = stopping;
+        }
+        drain();
+        if (last)
+            break;
+    }
+}
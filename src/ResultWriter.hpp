@@ -0,0 +1,63 @@
+// src/ResultWriter.hpp
+#ifndef RESULTWRITER_HPP
+#define RESULTWRITER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Асинхронная запись результатов. Воркеры дописывают строки в собственный буфер
+// (его мьютекс захватывает только сам поток и, раз в интервал, писатель), а отдельный
+// поток-писатель периодически забирает все буферы и пишет их одним writev.
+// Так на горячем пути нет ни глобальной блокировки, ни системного вызова на каждый результат.
+class ResultWriter {
+public:
+    // fd — уже открытый файл результатов. flushMs — максимальная задержка записи,
+    // syncData — fdatasync после каждой записи (долговечность ценой пропускной способности).
+    // header записывается синхронно до запуска потока-писателя.
+    static void start(int fd, int flushMs = 1000, bool syncData = false,
+                      const std::string& header = std::string());
+    static void stop();
+
+    // Добавляет строку (перевод строки дописывается автоматически)
+    static void writeLine(std::string_view line);
+    // Добавляет готовые байты записи как есть
+    static void write(std::string_view data);
+
+    // Журнал завершённых доменов (см. Journal): отпечатки пишутся пачкой
+    // после результатов того же сброса. fd = -1 — журнал отключён.
+    static void setJournal(int fd);
+    static void markDone(uint64_t fingerprint);
+
+private:
+    struct Buffer {
+        std::mutex  mtx;
+        std::string data;
+        std::string journal;
+        std::string spare; // записанный писателем блок возвращается сюда и становится следующим data
+    };
+
+    static Buffer& localBuffer();
+    static void run();
+    static void drain();
+    static bool writeAll(const char* data, size_t len);
+    static bool writeBlocks(int out, std::vector<std::string>& blocks);
+    static void recycleBlocks(std::vector<Buffer*>& owners, std::vector<std::string>& blocks);
+
+    static int fd;
+    static int journalFd;
+    static int flushMs;
+    static bool syncData;
+    static bool stopping;
+    static std::thread writerThread;
+    static std::mutex mtx;                 // реестр буферов и пробуждение писателя
+    static std::condition_variable wakeup;
+    static std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+#endif // RESULTWRITER_HPP
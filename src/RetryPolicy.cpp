@@ -0,0 +1,46 @@
+// src/RetryPolicy.cpp
+#include "RetryPolicy.hpp"
+#include <algorithm>
+
+bool RetryPolicy::isTransient(CURLcode result, long httpCode) {
+    switch (result) {
+    case CURLE_OK:
+        break;
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return true;
+    default:
+        // DNS (NXDOMAIN неотличим от сбоя), сертификаты, ошибки протокола и прерывание писателем
+        return false;
+    }
+    switch (httpCode) {
+    case 408: // Request Timeout
+    case 425: // Too Early
+    case 429: // Too Many Requests
+    case 500:
+    case 502:
+    case 503:
+    case 504:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t RetryPolicy::delayMs(int attempt, long long retryAfterSec, std::minstd_rand& rng) const {
+    uint64_t base = static_cast<uint64_t>(std::max(settings.baseDelayMs, 1));
+    uint64_t cap = static_cast<uint64_t>(std::max(settings.maxDelayMs, settings.baseDelayMs));
+    uint64_t exp = std::min<uint64_t>(cap, base << std::min(attempt, 20));
+    uint64_t half = exp / 2;
+    uint64_t delay = half + (half ? rng() % (half + 1) : 0);
+    if (retryAfterSec > 0)
+        delay = std::max<uint64_t>(delay, std::min<uint64_t>(cap, static_cast<uint64_t>(retryAfterSec) * 1000));
+    return static_cast<uint32_t>(delay);
+}
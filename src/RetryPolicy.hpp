@@ -0,0 +1,41 @@
+// src/RetryPolicy.hpp
+#ifndef RETRYPOLICY_HPP
+#define RETRYPOLICY_HPP
+
+#include <curl/curl.h>
+#include <cstdint>
+#include <random>
+
+// Классификация неудачных передач и расписание повторов.
+// Временные ошибки (таймауты, сбросы соединения, 408/425/429/5xx шлюзов) повторяются
+// с экспоненциальной задержкой и «равным» джиттером: половина задержки фиксирована,
+// половина случайна. Retry-After сервера (в секундах) увеличивает задержку.
+// Остальные ошибки (NXDOMAIN, отказ TLS-сертификата, 4xx и т.п.) считаются окончательными.
+class RetryPolicy {
+public:
+    struct Settings {
+        int maxRetries = 2;      // повторов на домен сверх первой попытки (0 — без повторов)
+        int baseDelayMs = 500;   // задержка перед первым повтором
+        int maxDelayMs = 30000;  // потолок задержки
+    };
+
+    RetryPolicy() = default;
+    explicit RetryPolicy(const Settings& s) : settings(s) {}
+
+    static bool isTransient(CURLcode result, long httpCode);
+
+    // Нужен ли повтор после попытки с номером attempt (0 — первая)
+    bool shouldRetry(int attempt, CURLcode result, long httpCode) const {
+        return attempt < settings.maxRetries && isTransient(result, httpCode);
+    }
+
+    // Задержка перед повтором номер attempt+1; retryAfterSec — заголовок Retry-After (или -1)
+    uint32_t delayMs(int attempt, long long retryAfterSec, std::minstd_rand& rng) const;
+
+    const Settings& config() const { return settings; }
+
+private:
+    Settings settings;
+};
+
+#endif // RETRYPOLICY_HPP
@@ -0,0 +1,856 @@
+// src/RuleSet.cpp
+#include "RuleSet.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t kMaxRepeat = 32; // верхняя граница {n,m}: шаблон разворачивается в копии элемента
+
+bool isIdentChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.';
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+// Регистронезависимость: буква в множестве — значит, и парная ей
+void foldCase(std::bitset<256>& set) {
+    for (int c = 'a'; c <= 'z'; ++c) {
+        if (set[c] || set[c - 'a' + 'A']) {
+            set.set(c);
+            set.set(c - 'a' + 'A');
+        }
+    }
+}
+
+void addEscapeClass(std::bitset<256>& set, char e) {
+    for (int c = 0; c < 256; ++c) {
+        bool in = false;
+        switch (e) {
+        case 'd': case 'D': in = std::isdigit(c); break;
+        case 'w': case 'W': in = std::isalnum(c) || c == '_'; break;
+        case 's': case 'S': in = c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; break;
+        }
+        if (std::isupper(static_cast<unsigned char>(e)) ? !in : in)
+            set.set(static_cast<size_t>(c));
+    }
+}
+
+// Символ после '\': \n \r \t или экранированный знак как есть
+char escapedChar(char e) {
+    switch (e) {
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    default:  return e;
+    }
+}
+
+bool isEscapeClass(char e) {
+    return e == 'd' || e == 'D' || e == 'w' || e == 'W' || e == 's' || e == 'S';
+}
+
+} // namespace
+
+// Разбор файла правил: рекурсивный спуск по выражению одной строки
+class RuleSet::Parser {
+public:
+    explicit Parser(RuleSet& rs) : rs(rs) {}
+
+    bool line(std::string_view text, std::string& error);
+
+    std::vector<Pattern> headerPatterns;
+    std::vector<Pattern> bodyPatterns;
+
+private:
+    void skipSpace() {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos])))
+            ++pos;
+    }
+    // Ключевое слово AND/OR/NOT целиком (не префикс идентификатора)
+    bool keyword(std::string_view kw) {
+        skipSpace();
+        if (s.size() - pos < kw.size() || !equalsIgnoreCase(s.substr(pos, kw.size()), kw))
+            return false;
+        if (pos + kw.size() < s.size() && isIdentChar(s[pos + kw.size()]))
+            return false;
+        pos += kw.size();
+        return true;
+    }
+    bool fail(const std::string& why) {
+        if (err.empty())
+            err = why;
+        return false;
+    }
+    uint32_t node(Node::Kind kind, uint32_t a, uint32_t b = 0) {
+        rs.nodes.push_back(Node{kind, a, b});
+        return static_cast<uint32_t>(rs.nodes.size() - 1);
+    }
+
+    bool expr(uint32_t& out);
+    bool term(uint32_t& out);
+    bool factor(uint32_t& out);
+    bool atom(uint32_t& out);
+    bool quoted(char quote, std::string& out);
+    bool literal(const std::string& text, std::vector<Item>& items);
+    bool regex(const std::string& text, std::vector<Item>& items);
+    bool charClass(const std::string& text, size_t& i, std::bitset<256>& set);
+    bool statusRange(std::string_view text, long& lo, long& hi);
+    uint32_t intern(Target target, const std::string& key, std::vector<Item>&& items);
+
+    RuleSet& rs;
+    std::string_view s;
+    size_t pos = 0;
+    std::string err;
+    std::map<std::string, uint32_t> atomIndex; // одинаковые условия разных правил — одно условие
+};
+
+bool RuleSet::Parser::line(std::string_view text, std::string& error) {
+    s = text;
+    pos = 0;
+    err.clear();
+    skipSpace();
+    size_t start = pos;
+    while (pos < s.size() && isIdentChar(s[pos]))
+        ++pos;
+    std::string id(s.substr(start, pos - start));
+    skipSpace();
+    if (id.empty() || pos >= s.size() || s[pos] != ':') {
+        error = "ожидается \"<id>: <выражение>\"";
+        return false;
+    }
+    ++pos;
+    for (const auto& r : rs.rules) {
+        if (r.id == id) {
+            error = "повторный id правила '" + id + "'";
+            return false;
+        }
+    }
+    uint32_t root = 0;
+    if (!expr(root)) {
+        error = err;
+        return false;
+    }
+    skipSpace();
+    if (pos != s.size()) {
+        error = "лишний текст после выражения: '" + std::string(s.substr(pos)) + "'";
+        return false;
+    }
+    rs.rules.push_back(Rule{std::move(id), root});
+    return true;
+}
+
+bool RuleSet::Parser::expr(uint32_t& out) {
+    if (!term(out))
+        return false;
+    while (keyword("OR")) {
+        uint32_t rhs = 0;
+        if (!term(rhs))
+            return false;
+        out = node(Node::Or, out, rhs);
+    }
+    return true;
+}
+
+bool RuleSet::Parser::term(uint32_t& out) {
+    if (!factor(out))
+        return false;
+    while (keyword("AND")) {
+        uint32_t rhs = 0;
+        if (!factor(rhs))
+            return false;
+        out = node(Node::And, out, rhs);
+    }
+    return true;
+}
+
+bool RuleSet::Parser::factor(uint32_t& out) {
+    if (keyword("NOT")) {
+        uint32_t inner = 0;
+        if (!factor(inner))
+            return false;
+        out = node(Node::Not, inner);
+        return true;
+    }
+    skipSpace();
+    if (pos < s.size() && s[pos] == '(') {
+        ++pos;
+        if (!expr(out))
+            return false;
+        skipSpace();
+        if (pos >= s.size() || s[pos] != ')')
+            return fail("не закрыта скобка");
+        ++pos;
+        return true;
+    }
+    return atom(out);
+}
+
+bool RuleSet::Parser::atom(uint32_t& out) {
+    skipSpace();
+    size_t start = pos;
+    while (pos < s.size() && std::isalpha(static_cast<unsigned char>(s[pos])))
+        ++pos;
+    std::string_view what = s.substr(start, pos - start);
+    if (pos >= s.size() || s[pos] != ':')
+        return fail("ожидается условие header:, body: или status:");
+    ++pos;
+
+    if (equalsIgnoreCase(what, "status")) {
+        size_t from = pos;
+        while (pos < s.size() && (std::isalnum(static_cast<unsigned char>(s[pos])) || s[pos] == '-'))
+            ++pos;
+        Atom a{Target::Status};
+        if (!statusRange(s.substr(from, pos - from), a.statusLo, a.statusHi))
+            return fail("неверный код статуса '" + std::string(s.substr(from, pos - from)) + "'");
+        std::string key = "s" + std::to_string(a.statusLo) + "-" + std::to_string(a.statusHi);
+        auto it = atomIndex.find(key);
+        if (it == atomIndex.end()) {
+            rs.atoms.push_back(a);
+            it = atomIndex.emplace(key, static_cast<uint32_t>(rs.atoms.size() - 1)).first;
+        }
+        out = node(Node::Leaf, it->second);
+        return true;
+    }
+
+    Target target;
+    if (equalsIgnoreCase(what, "header") || equalsIgnoreCase(what, "headers"))
+        target = Target::Header;
+    else if (equalsIgnoreCase(what, "body"))
+        target = Target::Body;
+    else
+        return fail("неизвестная цель условия '" + std::string(what) + "'");
+
+    if (pos >= s.size() || (s[pos] != '"' && s[pos] != '/'))
+        return fail("ожидается \"литерал\" или /выражение/");
+    char quote = s[pos];
+    std::string text;
+    if (!quoted(quote, text))
+        return false;
+    std::vector<Item> items;
+    std::string key;
+    if (quote == '"') {
+        if (!literal(text, items))
+            return false;
+        std::transform(text.begin(), text.end(), text.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        key = "l" + text;
+    } else {
+        if (!regex(text, items))
+            return false;
+        key = "r" + text;
+    }
+    out = node(Node::Leaf, intern(target, key, std::move(items)));
+    return true;
+}
+
+// Содержимое "..." или /.../; экранирование закрывающего символа и '\' сохраняется для regex
+bool RuleSet::Parser::quoted(char quote, std::string& out) {
+    ++pos;
+    while (pos < s.size() && s[pos] != quote) {
+        if (s[pos] == '\\' && pos + 1 < s.size()) {
+            char next = s[pos + 1];
+            if (quote == '"') {
+                out.push_back(escapedChar(next));
+            } else if (next == '/') {
+                out.push_back('/');
+            } else {
+                out.push_back('\\');
+                out.push_back(next);
+            }
+            pos += 2;
+            continue;
+        }
+        out.push_back(s[pos++]);
+    }
+    if (pos >= s.size())
+        return fail(std::string("не закрыт ") + (quote == '"' ? "литерал" : "шаблон"));
+    ++pos;
+    if (out.empty())
+        return fail("пустой шаблон");
+    return true;
+}
+
+bool RuleSet::Parser::literal(const std::string& text, std::vector<Item>& items) {
+    for (unsigned char c : text) {
+        Item it;
+        it.set.set(c);
+        foldCase(it.set);
+        items.push_back(it);
+    }
+    return true;
+}
+
+bool RuleSet::Parser::charClass(const std::string& text, size_t& i, std::bitset<256>& set) {
+    ++i; // '['
+    bool negate = i < text.size() && text[i] == '^';
+    if (negate)
+        ++i;
+    bool first = true;
+    while (i < text.size() && (text[i] != ']' || first)) {
+        first = false;
+        unsigned char lo = static_cast<unsigned char>(text[i]);
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            char e = text[i + 1];
+            i += 2;
+            if (isEscapeClass(e)) {
+                addEscapeClass(set, e);
+                continue;
+            }
+            lo = static_cast<unsigned char>(escapedChar(e));
+        } else {
+            ++i;
+        }
+        unsigned char hi = lo;
+        if (i + 1 < text.size() && text[i] == '-' && text[i + 1] != ']') {
+            hi = static_cast<unsigned char>(text[i + 1]);
+            if (text[i + 1] == '\\' && i + 2 < text.size()) {
+                hi = static_cast<unsigned char>(escapedChar(text[i + 2]));
+                ++i;
+            }
+            i += 2;
+            if (hi < lo)
+                return fail("неверный диапазон в классе символов");
+        }
+        for (unsigned c = lo; c <= hi; ++c)
+            set.set(c);
+    }
+    if (i >= text.size())
+        return fail("не закрыт класс символов [");
+    ++i; // ']'
+    foldCase(set);
+    if (negate)
+        set.flip();
+    return true;
+}
+
+bool RuleSet::Parser::regex(const std::string& text, std::vector<Item>& items) {
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        Item it;
+        switch (c) {
+        case '(': case ')': case '|':
+            return fail("группы и альтернативы в шаблонах не поддерживаются");
+        case '^': case '$':
+            return fail("якоря ^ и $ не поддерживаются (поиск идёт в любом месте потока)");
+        case '*': case '+': case '?': case '{':
+            return fail("квантификатор без операнда");
+        case '.':
+            it.set.set();
+            it.set.reset('\n');
+            ++i;
+            break;
+        case '[':
+            if (!charClass(text, i, it.set))
+                return false;
+            break;
+        case '\\':
+            if (i + 1 >= text.size())
+                return fail("'\\' в конце шаблона");
+            if (isEscapeClass(text[i + 1]))
+                addEscapeClass(it.set, text[i + 1]);
+            else
+                it.set.set(static_cast<unsigned char>(escapedChar(text[i + 1])));
+            i += 2;
+            break;
+        default:
+            it.set.set(static_cast<unsigned char>(c));
+            ++i;
+        }
+        foldCase(it.set);
+
+        // Квантификатор разворачивается в копии элемента: X+ = X X*, X{2,4} = X X X? X?
+        size_t minRep = 1, maxRep = 1;
+        bool unbounded = false;
+        if (i < text.size()) {
+            switch (text[i]) {
+            case '*': minRep = 0; unbounded = true; ++i; break;
+            case '+': unbounded = true; ++i; break;
+            case '?': minRep = 0; ++i; break;
+            case '{': {
+                size_t close = text.find('}', i);
+                if (close == std::string::npos)
+                    return fail("не закрыт квантификатор {");
+                std::string body = text.substr(i + 1, close - i - 1);
+                size_t comma = body.find(',');
+                char* end = nullptr;
+                minRep = std::strtoul(body.c_str(), &end, 10);
+                if (end == body.c_str())
+                    return fail("неверный квантификатор {" + body + "}");
+                if (comma == std::string::npos) {
+                    maxRep = minRep;
+                } else if (comma + 1 == body.size()) {
+                    unbounded = true;
+                } else {
+                    maxRep = std::strtoul(body.c_str() + comma + 1, &end, 10);
+                    if (*end)
+                        return fail("неверный квантификатор {" + body + "}");
+                }
+                if ((!unbounded && maxRep < minRep) || minRep > kMaxRepeat || (!unbounded && maxRep > kMaxRepeat))
+                    return fail("квантификатор {" + body + "} вне пределов (до " + std::to_string(kMaxRepeat) + ")");
+                i = close + 1;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        for (size_t r = 0; r < minRep; ++r)
+            items.push_back(it);
+        if (unbounded) {
+            it.quant = Item::Star;
+            items.push_back(it);
+        } else {
+            it.quant = Item::Opt;
+            for (size_t r = minRep; r < maxRep; ++r)
+                items.push_back(it);
+        }
+    }
+    // Для поиска в любом месте необязательные элементы по краям ничего не меняют:
+    // /bitrix_sm_\w+/ находится тогда же, когда /bitrix_sm_\w/. Срезаем их — меньше состояний.
+    auto required = [](const Item& it) { return it.quant == Item::One; };
+    auto first = std::find_if(items.begin(), items.end(), required);
+    if (first == items.end())
+        return fail("шаблон совпадает с пустой строкой");
+    items.erase(items.begin(), first);
+    items.erase(std::find_if(items.rbegin(), items.rend(), required).base(), items.end());
+    return true;
+}
+
+// "404", "4xx", "400-499"
+bool RuleSet::Parser::statusRange(std::string_view text, long& lo, long& hi) {
+    auto parse3 = [](std::string_view v, long& low, long& high) {
+        if (v.size() != 3 || !std::isdigit(static_cast<unsigned char>(v[0])))
+            return false;
+        low = high = 0;
+        bool wildcard = false;
+        for (char c : v) {
+            if (std::isdigit(static_cast<unsigned char>(c)) && !wildcard) {
+                low = low * 10 + (c - '0');
+                high = high * 10 + (c - '0');
+            } else if (c == 'x' || c == 'X') {
+                wildcard = true;
+                low = low * 10;
+                high = high * 10 + 9;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    };
+    size_t dash = text.find('-');
+    if (dash == std::string_view::npos)
+        return parse3(text, lo, hi);
+    long unused = 0;
+    return parse3(text.substr(0, dash), lo, unused) && parse3(text.substr(dash + 1), unused, hi) && lo <= hi;
+}
+
+uint32_t RuleSet::Parser::intern(Target target, const std::string& key, std::vector<Item>&& items) {
+    std::string full = (target == Target::Header ? "h" : "b") + key;
+    auto it = atomIndex.find(full);
+    if (it != atomIndex.end())
+        return it->second;
+    uint32_t id = static_cast<uint32_t>(rs.atoms.size());
+    rs.atoms.push_back(Atom{target});
+    atomIndex.emplace(std::move(full), id);
+    auto& patterns = target == Target::Header ? headerPatterns : bodyPatterns;
+    patterns.push_back(Pattern{std::move(items), id});
+    return id;
+}
+
+bool RuleSet::load(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "не удалось открыть " + path;
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return compile(ss.str(), error);
+}
+
+bool RuleSet::compile(const std::string& text, std::string& error) {
+    rules.clear();
+    nodes.clear();
+    atoms.clear();
+    Parser parser(*this);
+    std::istringstream in(text);
+    std::string lineText;
+    size_t lineNo = 0;
+    while (std::getline(in, lineText)) {
+        ++lineNo;
+        std::string_view line = lineText;
+        size_t b = line.find_first_not_of(" \t\r");
+        if (b == std::string_view::npos || line[b] == '#')
+            continue;
+        size_t e = line.find_last_not_of(" \t\r");
+        if (!parser.line(line.substr(b, e - b + 1), error)) {
+            error = "строка " + std::to_string(lineNo) + ": " + error;
+            return false;
+        }
+    }
+    if (rules.empty()) {
+        error = "в файле нет ни одного правила";
+        return false;
+    }
+
+    rulesOfAtom.assign(atoms.size(), {});
+    for (uint32_t r = 0; r < rules.size(); ++r) {
+        // Обход дерева правила: собираем его условия
+        std::vector<uint32_t> stack{rules[r].root};
+        while (!stack.empty()) {
+            const Node& n = nodes[stack.back()];
+            stack.pop_back();
+            if (n.kind == Node::Leaf) {
+                auto& list = rulesOfAtom[n.a];
+                if (list.empty() || list.back() != r)
+                    list.push_back(r);
+            } else {
+                stack.push_back(n.a);
+                if (n.kind != Node::Not)
+                    stack.push_back(n.b);
+            }
+        }
+    }
+    hasHeaderPatterns = !parser.headerPatterns.empty();
+    hasBodyPatterns = !parser.bodyPatterns.empty();
+    build(parser.headerPatterns, headerNfa);
+    build(parser.bodyPatterns, bodyNfa);
+    return true;
+}
+
+// Плоские позиции всех шаблонов, классы байтов и переходы из стартовых позиций
+void RuleSet::build(const std::vector<Pattern>& patterns, Nfa& out) {
+    out = Nfa();
+    std::vector<uint32_t> starts;
+    for (const auto& p : patterns) {
+        starts.push_back(static_cast<uint32_t>(out.items.size()));
+        for (const auto& it : p.items) {
+            out.items.push_back(it);
+            out.endAtom.push_back(UINT32_MAX);
+        }
+        out.items.push_back(Item()); // пустое множество: из конца шаблона переходов нет
+        out.endAtom.push_back(p.atom);
+    }
+
+    // Классы байтов: байты, входящие в одни и те же множества, неразличимы для автомата
+    std::vector<std::bitset<256>> sets;
+    for (size_t id = 0; id < out.items.size(); ++id) {
+        const auto& set = out.items[id].set;
+        if (out.endAtom[id] == UINT32_MAX && std::find(sets.begin(), sets.end(), set) == sets.end())
+            sets.push_back(set);
+    }
+    std::map<std::vector<bool>, uint32_t> classIndex;
+    for (unsigned c = 0; c < 256; ++c) {
+        std::vector<bool> sig(sets.size());
+        for (size_t j = 0; j < sets.size(); ++j)
+            sig[j] = sets[j][c];
+        auto ins = classIndex.emplace(std::move(sig), static_cast<uint32_t>(out.classRep.size()));
+        if (ins.second)
+            out.classRep.push_back(static_cast<uint16_t>(c));
+        out.classOf[c] = static_cast<uint8_t>(ins.first->second);
+    }
+    out.numClasses = static_cast<uint32_t>(out.classRep.size());
+
+    // Стартовые позиции с замыканием (пропуск необязательных элементов)
+    out.inStart.assign(out.items.size(), 0);
+    std::vector<uint32_t> startSet;
+    for (uint32_t id : starts) {
+        for (uint32_t p = id; !out.inStart[p]; ++p) {
+            out.inStart[p] = 1;
+            startSet.push_back(p);
+            if (out.items[p].quant == Item::One)
+                break;
+        }
+    }
+    out.startNext.assign(out.numClasses, {});
+    std::vector<char> seen(out.items.size(), 0);
+    for (uint32_t c = 0; c < out.numClasses; ++c) {
+        auto& next = out.startNext[c];
+        for (uint32_t id : startSet) {
+            const Item& it = out.items[id];
+            if (out.endAtom[id] != UINT32_MAX || !it.set[out.classRep[c]])
+                continue;
+            // Переход и замыкание: за необязательным элементом доступен следующий
+            for (uint32_t p = it.quant == Item::Star ? id : id + 1; !seen[p]; ++p) {
+                seen[p] = 1;
+                next.push_back(p);
+                if (out.endAtom[p] != UINT32_MAX || out.items[p].quant == Item::One)
+                    break;
+            }
+        }
+        for (uint32_t p : next)
+            seen[p] = 0;
+    }
+}
+
+void RuleSet::Dfa::init(const Nfa& n) {
+    nfa = &n;
+    // Предел кэша — около 4 МБ таблицы переходов на автомат
+    maxStates = std::max<size_t>(256, (size_t(4) << 20) / (sizeof(uint32_t) * n.numClasses));
+    mark.assign(n.items.size(), 0);
+    flush();
+    flushes = 0;
+}
+
+// Кэш переполнен: начинаем заново со стартового состояния. Передачи, стоящие
+// в старых состояниях, восстанавливаются по своим копиям наборов (State::headerSet/bodySet).
+void RuleSet::Dfa::flush() {
+    sets.clear();
+    index.clear();
+    delta.clear();
+    outStart.assign(1, 0);
+    outList.clear();
+    ++epoch;
+    ++flushes;
+    intern(std::vector<uint32_t>());
+}
+
+// Номер состояния для набора позиций (набор без стартовых, отсортирован); возвращает строку
+uint32_t RuleSet::Dfa::intern(const std::vector<uint32_t>& set) {
+    key.assign(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(uint32_t));
+    auto it = index.find(key);
+    if (it != index.end())
+        return it->second * nfa->numClasses;
+    uint32_t id = static_cast<uint32_t>(sets.size());
+    sets.push_back(set);
+    index.emplace(key, id);
+    delta.resize(delta.size() + nfa->numClasses, kUnknown);
+    for (uint32_t p : set) {
+        if (nfa->endAtom[p] != UINT32_MAX)
+            outList.push_back(nfa->endAtom[p]);
+    }
+    outStart.push_back(static_cast<uint32_t>(outList.size()));
+    return id * nfa->numClasses;
+}
+
+// Вычисляет переход из строки row по классу cls (медленный путь, один раз на переход в поколении)
+uint32_t RuleSet::Dfa::transition(uint32_t row, uint32_t cls) {
+    const Nfa& n = *nfa;
+    if (++stamp == 0) {
+        std::fill(mark.begin(), mark.end(), 0);
+        stamp = 1;
+    }
+    next.clear();
+    auto add = [&](uint32_t p) {
+        if (mark[p] != stamp) {
+            mark[p] = stamp;
+            next.push_back(p);
+        }
+    };
+    for (uint32_t p : n.startNext[cls])
+        add(p);
+    const unsigned byte = n.classRep[cls];
+    for (uint32_t p : sets[row / n.numClasses]) {
+        const Item& it = n.items[p];
+        if (n.endAtom[p] == UINT32_MAX && it.set[byte])
+            add(it.quant == Item::Star ? p : p + 1);
+    }
+    // Замыкание: за необязательным элементом доступен следующий
+    for (size_t i = 0; i < next.size(); ++i) {
+        uint32_t p = next[i];
+        if (n.endAtom[p] == UINT32_MAX && n.items[p].quant != Item::One)
+            add(p + 1);
+    }
+    next.erase(std::remove_if(next.begin(), next.end(), [&](uint32_t p) { return n.inStart[p]; }),
+               next.end());
+    std::sort(next.begin(), next.end());
+
+    bool full = sets.size() >= maxStates;
+    if (full) {
+        key.assign(reinterpret_cast<const char*>(next.data()), next.size() * sizeof(uint32_t));
+        if (index.find(key) == index.end()) {
+            std::vector<uint32_t> target = std::move(next);
+            flush();
+            next = std::move(target);
+        } else {
+            full = false;
+        }
+    }
+    uint32_t target = intern(next);
+    uint32_t state = target / n.numClasses;
+    if (outStart[state] != outStart[state + 1])
+        target |= kOutputFlag;
+    // После сброса строки row больше нет — запоминать переход некуда
+    if (!full)
+        delta[row + cls] = target;
+    return target;
+}
+
+RuleSet::Cache::Cache(const RuleSet& rules) {
+    header.init(rules.headerNfa);
+    body.init(rules.bodyNfa);
+}
+
+void RuleSet::reset(State& st) const {
+    st.headerNode = 0;
+    st.bodyNode = 0;
+    st.headerEpoch = 0;
+    st.bodyEpoch = 0;
+    st.headerSet.clear();
+    st.bodySet.clear();
+    st.status = 0;
+    st.headersDone = false;
+    st.bodyDone = false;
+    st.undecided = rules.size();
+    st.found.assign((atoms.size() + 63) / 64, 0);
+    st.decided.assign((rules.size() + 63) / 64, 0);
+    st.matched.assign((rules.size() + 63) / 64, 0);
+}
+
+int RuleSet::eval(const State& st, uint32_t n) const {
+    const Node& node = nodes[n];
+    switch (node.kind) {
+    case Node::Leaf: {
+        if ((st.found[node.a / 64] >> (node.a % 64)) & 1)
+            return 1;
+        switch (atoms[node.a].target) {
+        case Target::Status: return st.status || st.headersDone ? 0 : 2;
+        case Target::Header: return st.headersDone ? 0 : 2;
+        default:             return st.bodyDone ? 0 : 2;
+        }
+    }
+    case Node::Not: {
+        int v = eval(st, node.a);
+        return v == 2 ? 2 : 1 - v;
+    }
+    case Node::And: {
+        int x = eval(st, node.a);
+        if (x == 0)
+            return 0;
+        int y = eval(st, node.b);
+        if (y == 0)
+            return 0;
+        return x == 1 && y == 1 ? 1 : 2;
+    }
+    case Node::Or: {
+        int x = eval(st, node.a);
+        if (x == 1)
+            return 1;
+        int y = eval(st, node.b);
+        if (y == 1)
+            return 1;
+        return x == 0 && y == 0 ? 0 : 2;
+    }
+    }
+    return 2;
+}
+
+void RuleSet::evaluate(State& st, uint32_t rule) const {
+    uint64_t bit = uint64_t(1) << (rule % 64);
+    if (st.decided[rule / 64] & bit)
+        return;
+    int v = eval(st, rules[rule].root);
+    if (v == 2)
+        return;
+    st.decided[rule / 64] |= bit;
+    if (v == 1)
+        st.matched[rule / 64] |= bit;
+    --st.undecided;
+}
+
+bool RuleSet::evaluateAll(State& st) const {
+    for (uint32_t r = 0; r < rules.size() && st.undecided; ++r)
+        evaluate(st, r);
+    return st.undecided == 0;
+}
+
+bool RuleSet::markFound(State& st, uint32_t atom) const {
+    uint64_t bit = uint64_t(1) << (atom % 64);
+    if (!(st.found[atom / 64] & bit)) {
+        st.found[atom / 64] |= bit;
+        for (uint32_t r : rulesOfAtom[atom])
+            evaluate(st, r);
+    }
+    return st.undecided == 0;
+}
+
+bool RuleSet::onStatus(State& st, long code) const {
+    st.status = code;
+    for (uint32_t a = 0; a < atoms.size(); ++a) {
+        if (atoms[a].target == Target::Status && code >= atoms[a].statusLo && code <= atoms[a].statusHi)
+            st.found[a / 64] |= uint64_t(1) << (a % 64);
+    }
+    return evaluateAll(st);
+}
+
+bool RuleSet::feed(State& st, Dfa& d, uint32_t& node, uint32_t& epoch, std::vector<uint32_t>& set,
+                   const char* data, size_t len) const {
+    if (epoch != d.epoch) {
+        // Кэш сбрасывался, пока передача ждала данных: переносим её набор позиций
+        // в новое поколение
+        node = set.empty() ? 0 : d.intern(set);
+        epoch = d.epoch;
+    }
+    const uint8_t* cls = d.nfa->classOf;
+    const uint32_t* delta = d.delta.data();
+    uint32_t row = node;
+    bool done = false;
+    for (size_t i = 0; i < len && !done; ++i) {
+        uint32_t c = cls[static_cast<unsigned char>(data[i])];
+        uint32_t next = delta[row + c];
+        if (next == Dfa::kUnknown) {
+            next = d.transition(row, c);
+            delta = d.delta.data();
+            epoch = d.epoch;
+        }
+        row = next;
+        if (row & kOutputFlag) {
+            row &= ~kOutputFlag;
+            uint32_t s = row / d.nfa->numClasses;
+            for (uint32_t o = d.outStart[s]; o < d.outStart[s + 1] && !done; ++o)
+                done = markFound(st, d.outList[o]);
+        }
+    }
+    node = row;
+    if (row)
+        set = d.sets[row / d.nfa->numClasses];
+    else
+        set.clear();
+    return done || st.undecided == 0;
+}
+
+bool RuleSet::feedHeader(State& st, Cache& cache, const char* data, size_t len) const {
+    if (st.undecided == 0 || !hasHeaderPatterns)
+        return st.undecided == 0;
+    return feed(st, cache.header, st.headerNode, st.headerEpoch, st.headerSet, data, len);
+}
+
+bool RuleSet::endHeaders(State& st) const {
+    st.headersDone = true;
+    return evaluateAll(st);
+}
+
+bool RuleSet::feedBody(State& st, Cache& cache, const char* data, size_t len) const {
+    if (st.undecided == 0 || !hasBodyPatterns)
+        return st.undecided == 0;
+    return feed(st, cache.body, st.bodyNode, st.bodyEpoch, st.bodySet, data, len);
+}
+
+void RuleSet::finish(State& st, bool bodyComplete) const {
+    // Ответа не было вовсе (ошибка соединения) или тело оборвано: отрицания не должны срабатывать
+    if (!st.status || !bodyComplete)
+        return;
+    st.headersDone = true;
+    st.bodyDone = true;
+    evaluateAll(st);
+}
+
+bool RuleSet::anyMatched(const State& st) const {
+    return std::any_of(st.matched.begin(), st.matched.end(), [](uint64_t w) { return w != 0; });
+}
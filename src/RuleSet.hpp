@@ -0,0 +1,198 @@
+// src/RuleSet.hpp
+#ifndef RULESET_HPP
+#define RULESET_HPP
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Набор правил классификации ответов (--rules=FILE), например для распознавания CMS.
+// Формат файла — по правилу в строке, '#' — комментарий:
+//
+//   bitrix:  header:"x-powered-by: bitrix" OR header:/set-cookie: *bitrix_sm_\w+/
+//   wp:      body:"/wp-content/" AND NOT body:"joomla"
+//   gone:    status:404 OR status:5xx
+//
+// Условия: header:/body: с литералом "..." или регулярным выражением /.../,
+// status:NNN, status:Nxx, status:NNN-NNN; связки AND, OR, NOT и скобки.
+// Сравнение регистронезависимое (ASCII). Регулярные выражения — безопасное
+// подмножество без групп, альтернатив и обратных ссылок: символы, '.', классы [...],
+// \d \w \s, квантификаторы * + ? {n} {n,m}.
+//
+// Все литералы и выражения одной цели (заголовки/тело) образуют один автомат,
+// который проходится по потоку один раз, как у KeywordMatcher. Детерминированный
+// автомат строится лениво: каждый поток держит свой Cache, состояния и переходы
+// появляются по мере того, как их требует реальный трафик (число состояний
+// полного ДКА для выражений с повторами растёт экспоненциально). Переполненный
+// кэш сбрасывается целиком.
+// Каждое правило вычисляется в трёхзначной логике: условие по потоку, который
+// ещё идёт, «неизвестно», пока не найдено. Когда все правила решены, передачу
+// можно прервать.
+class RuleSet {
+public:
+    struct State {
+        uint32_t              headerNode = 0; // строки автоматов (переживают границы кусков)
+        uint32_t              bodyNode = 0;
+        uint32_t              headerEpoch = 0; // поколение кэша, к которому относится строка
+        uint32_t              bodyEpoch = 0;
+        // Наборы позиций НКА на конец последнего куска: по ним строка восстанавливается,
+        // если кэш сбрасывался (сколько угодно раз), пока передача ждала данных
+        std::vector<uint32_t> headerSet;
+        std::vector<uint32_t> bodySet;
+        long                  status = 0;     // 0 — статусная строка ещё не пришла
+        bool                  headersDone = false;
+        bool                  bodyDone = false;
+        size_t                undecided = 0;  // сколько правил ещё не решено
+        std::vector<uint64_t> found;          // найденные условия (биты по номеру условия)
+        std::vector<uint64_t> decided;        // решённые правила
+        std::vector<uint64_t> matched;        // правила, решённые как истинные
+    };
+
+    class Cache;
+
+    // Читает и компилирует файл; при ошибке error содержит номер строки и причину
+    bool load(const std::string& path, std::string& error);
+    bool compile(const std::string& text, std::string& error);
+
+    bool empty() const { return rules.empty(); }
+    size_t size() const { return rules.size(); }
+    const std::string& id(size_t rule) const { return rules[rule].id; }
+
+    // Подготавливает состояние к новому ответу (в т.ч. после редиректа)
+    void reset(State& st) const;
+
+    // Статусная строка ответа. Возвращает true, когда все правила решены.
+    bool onStatus(State& st, long code) const;
+    // Очередная строка заголовков
+    bool feedHeader(State& st, Cache& cache, const char* data, size_t len) const;
+    // Заголовки окончательного ответа закончились
+    bool endHeaders(State& st) const;
+    // Очередной кусок тела
+    bool feedBody(State& st, Cache& cache, const char* data, size_t len) const;
+    // Передача завершена: всё, что не найдено, считается отсутствующим.
+    // Без статусной строки правила остаются нерешёнными (и не совпавшими).
+    // bodyComplete == false — ответ оборван (--max-bytes, снятие по сроку, ошибка):
+    // непросмотренное тело ничего не доказывает, условия по нему остаются неизвестными.
+    void finish(State& st, bool bodyComplete = true) const;
+
+    bool decided(const State& st) const { return st.undecided == 0; }
+    bool matched(const State& st, size_t rule) const {
+        return rule / 64 < st.matched.size() && (st.matched[rule / 64] >> (rule % 64)) & 1;
+    }
+    bool anyMatched(const State& st) const;
+
+private:
+    enum class Target : uint8_t { Header, Body, Status };
+
+    // Условие: шаблон в одном из автоматов или диапазон кодов статуса
+    struct Atom {
+        Target target;
+        long   statusLo = 0, statusHi = 0;
+    };
+
+    // Узел выражения правила
+    struct Node {
+        enum Kind : uint8_t { Leaf, Not, And, Or } kind;
+        uint32_t a = 0, b = 0; // Leaf: a — номер условия; Not: a; And/Or: a, b
+    };
+
+    struct Rule {
+        std::string id;
+        uint32_t    root = 0;
+    };
+
+    // Элемент шаблона: множество байтов и квантификатор
+    struct Item {
+        std::bitset<256> set;
+        enum Quant : uint8_t { One, Opt, Star } quant = One;
+    };
+    struct Pattern {
+        std::vector<Item> items;
+        uint32_t          atom = 0;
+    };
+
+    // Недетерминированный автомат набора шаблонов. Позиция — (шаблон, сколько
+    // элементов пройдено); конец шаблона — позиция с endAtom. Стартовые позиции
+    // (вместе с замыканием) присутствуют в каждом состоянии ДКА неявно: поиск идёт
+    // в любом месте потока, поэтому состояние хранит только продвинувшиеся позиции,
+    // и для литералов это ровно узлы бора Ахо-Корасик.
+    struct Nfa {
+        std::vector<Item>                  items;
+        std::vector<uint32_t>              endAtom;   // UINT32_MAX — не конец шаблона
+        std::vector<char>                  inStart;
+        uint8_t                            classOf[256] = {}; // байты, неразличимые для шаблонов
+        std::vector<uint16_t>              classRep;  // представитель класса
+        uint32_t                           numClasses = 1;
+        std::vector<std::vector<uint32_t>> startNext; // переходы из стартовых позиций по классам
+    };
+    static constexpr uint32_t kOutputFlag = 0x80000000u;
+
+    class Parser;
+    struct Dfa;
+
+    static void build(const std::vector<Pattern>& patterns, Nfa& out);
+    bool feed(State& st, Dfa& d, uint32_t& node, uint32_t& epoch, std::vector<uint32_t>& set,
+              const char* data, size_t len) const;
+
+    bool markFound(State& st, uint32_t atom) const;
+    // 0 — ложь, 1 — истина, 2 — неизвестно
+    int eval(const State& st, uint32_t node) const;
+    void evaluate(State& st, uint32_t rule) const;
+    bool evaluateAll(State& st) const;
+
+    std::vector<Rule>                  rules;
+    std::vector<Node>                  nodes;
+    std::vector<Atom>                  atoms;
+    std::vector<std::vector<uint32_t>> rulesOfAtom; // какие правила пересчитывать при находке
+    Nfa                                headerNfa;
+    Nfa                                bodyNfa;
+    bool                               hasHeaderPatterns = false;
+    bool                               hasBodyPatterns = false;
+};
+
+// Ленивый ДКА по Nfa: состояние — отсортированный набор позиций, строка переходов
+// заполняется по мере надобности (kUnknown — ещё не вычислено)
+struct RuleSet::Dfa {
+    static constexpr uint32_t kUnknown = UINT32_MAX;
+
+    const Nfa*                         nfa = nullptr;
+    size_t                             maxStates = 0;
+    uint32_t                           epoch = 1;  // растёт при каждом сбросе
+    std::vector<std::vector<uint32_t>> sets;
+    std::unordered_map<std::string, uint32_t> index;
+    // delta[row + class] = строка следующего состояния; kOutputFlag — в нём заканчиваются шаблоны
+    std::vector<uint32_t>              delta;
+    std::vector<uint32_t>              outStart{0}; // выходы состояния: outList[outStart[s] .. outStart[s+1])
+    std::vector<uint32_t>              outList;
+    size_t                             flushes = 0;
+    // Рабочие буферы построения
+    std::vector<uint32_t>              mark;
+    uint32_t                           stamp = 0;
+    std::vector<uint32_t>              next;
+    std::string                        key;
+
+    void init(const Nfa& n);
+    void flush();
+    uint32_t intern(const std::vector<uint32_t>& set);
+    uint32_t transition(uint32_t row, uint32_t cls);
+};
+
+// Кэш ленивых автоматов одного потока (TransferPool). Переходы, уже встречавшиеся
+// в трафике, стоят одного обращения к таблице, как у KeywordMatcher.
+class RuleSet::Cache {
+public:
+    explicit Cache(const RuleSet& rules);
+
+    // Сколько раз кэш переполнялся и сбрасывался
+    size_t flushes() const { return header.flushes + body.flushes; }
+
+private:
+    friend class RuleSet;
+    Dfa header;
+    Dfa body;
+};
+
+#endif // RULESET_HPP
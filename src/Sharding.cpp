@@ -0,0 +1,55 @@
+// src/Sharding.cpp
+#include "Sharding.hpp"
+#include "DomainNormalizer.hpp"
+#include "DomainTask.hpp"
+#include "FingerprintSet.hpp"
+#include <cstdlib>
+
+size_t              Sharding::index = 0;
+size_t              Sharding::count = 1;
+std::atomic<size_t> Sharding::skipped{0};
+
+bool Sharding::parse(const std::string& spec) {
+    size_t slash = spec.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 == spec.size() ||
+        spec.find_first_not_of("0123456789/") != std::string::npos)
+        return false;
+    long i = std::atol(spec.c_str());
+    long n = std::atol(spec.c_str() + slash + 1);
+    if (n <= 0 || i < 0 || i >= n)
+        return false;
+    index = static_cast<size_t>(i);
+    count = static_cast<size_t>(n);
+    return true;
+}
+
+uint64_t Sharding::key(std::string_view line) {
+    thread_local std::string host;
+    thread_local std::string canonical;
+    int port = 0;
+    while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+        line.remove_prefix(1);
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r' || line.back() == '\n'))
+        line.remove_suffix(1);
+    splitHostPort(line, host, port);
+
+    // Имя хоста в той же канонической форме, что даёт нормализация входа
+    bool ascii = true;
+    for (char& c : host) {
+        if (static_cast<unsigned char>(c) >= 0x80)
+            ascii = false;
+        else if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c + 32);
+    }
+    std::string_view name = host;
+    if (!ascii) {
+        thread_local DomainNormalizer idn{DomainNormalizer::Settings()};
+        if (idn.normalize(host, canonical))
+            name = canonical;
+    }
+    return FingerprintSet::fingerprint(registrableDomain(name));
+}
+
+bool Sharding::owns(std::string_view line) {
+    return count <= 1 || key(line) % count == index;
+}
@@ -0,0 +1,39 @@
+// src/Sharding.hpp
+#ifndef SHARDING_HPP
+#define SHARDING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Детерминированное разбиение входа между узлами (--shard=i/N). Узел берёт строку,
+// если отпечаток её регистрируемого домена по модулю N равен i. Ключ не зависит от
+// схемы, порта, пути, регистра, "www." и формы записи IDN, поэтому все вариации одного
+// сайта, его поддомены и редиректы внутри него попадают на один узел — и дедупликация
+// на узле (--dedup) равносильна общей. Работает в обоих режимах чтения входа.
+class Sharding {
+public:
+    // "i/N", 0 <= i < N; false — неверная запись
+    static bool parse(const std::string& spec);
+
+    static bool enabled() { return count > 1; }
+    // Принадлежит ли строка этому узлу (без разбиения — всегда)
+    static bool owns(std::string_view line);
+    // Отпечаток регистрируемого домена строки
+    static uint64_t key(std::string_view line);
+
+    static size_t shardIndex() { return index; }
+    static size_t shardCount() { return count; }
+    // Чужие строки считают вызывающие (поток-загрузчик, воркеры в режиме mmap) и сдают итог сюда
+    static void addSkipped(size_t n) { skipped.fetch_add(n, std::memory_order_relaxed); }
+    static size_t skippedCount() { return skipped.load(std::memory_order_relaxed); }
+
+private:
+    static size_t index;
+    static size_t count;
+    static std::atomic<size_t> skipped;
+};
+
+#endif // SHARDING_HPP
@@ -0,0 +1,121 @@
+// src/StatsServer.cpp
+#include "StatsServer.hpp"
+#include "Metrics.hpp"
+#include "Logger.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int               StatsServer::listenFd = -1;
+std::atomic<bool> StatsServer::stopping{false};
+std::thread       StatsServer::serverThread;
+
+bool StatsServer::start(const std::string& address) {
+    std::string host = "127.0.0.1";
+    std::string port = address;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+    }
+    int portNum = std::atoi(port.c_str());
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(static_cast<uint16_t>(portNum));
+    if (portNum <= 0 || portNum > 65535 || inet_pton(AF_INET, host.c_str(), &sa.sin_addr) != 1) {
+        Logger::error("Invalid stats address: %s (expected [ip:]port)", address.c_str());
+        return false;
+    }
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        Logger::error("StatsServer: socket failed: %s", std::strerror(errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 || listen(listenFd, 16) != 0) {
+        Logger::error("StatsServer: cannot listen on %s:%d: %s", host.c_str(), portNum, std::strerror(errno));
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    stopping = false;
+    serverThread = std::thread(&StatsServer::run);
+    Logger::info("Metrics available at http://%s:%d/metrics", host.c_str(), portNum);
+    return true;
+}
+
+void StatsServer::stop() {
+    if (listenFd < 0)
+        return;
+    stopping = true;
+    if (serverThread.joinable())
+        serverThread.join();
+    close(listenFd);
+    listenFd = -1;
+}
+
+void StatsServer::run() {
+    // Таймаут poll ограничивает задержку остановки
+    pollfd pfd{listenFd, POLLIN, 0};
+    while (!stopping) {
+        int n = poll(&pfd, 1, 200);
+        if (n <= 0)
+            continue;
+        int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0)
+            continue;
+        serve(client);
+        close(client);
+    }
+}
+
+void StatsServer::serve(int client) {
+    // Медленный клиент не должен задерживать остановку дольше секунды
+    timeval tv{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char buf[4096];
+    size_t len = 0;
+    while (len < sizeof(buf)) {
+        ssize_t n = recv(client, buf + len, sizeof(buf) - len, 0);
+        if (n <= 0)
+            break;
+        len += static_cast<size_t>(n);
+        if (std::string_view(buf, len).find("\r\n\r\n") != std::string_view::npos)
+            break;
+    }
+    std::string_view request(buf, len);
+    std::string_view line = request.substr(0, request.find("\r\n"));
+
+    std::string body;
+    const char* status = "200 OK";
+    if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET / ", 0) == 0) {
+        body = Metrics::renderPrometheus();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+    std::string response = "HTTP/1.0 ";
+    response.append(status)
+        .append("\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: ")
+        .append(std::to_string(body.size()))
+        .append("\r\nConnection: close\r\n\r\n")
+        .append(body);
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        sent += static_cast<size_t>(n);
+    }
+}
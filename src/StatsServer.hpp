@@ -0,0 +1,27 @@
+// src/StatsServer.hpp
+#ifndef STATSSERVER_HPP
+#define STATSSERVER_HPP
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+// Минимальный HTTP-эндпоинт метрик (--stats=[ip:]port). Один поток, poll на
+// слушающем сокете; GET /metrics отдаёт Metrics::renderPrometheus(). Запросы
+// обслуживаются по одному: это инструмент наблюдения, а не сервер под нагрузку.
+// По умолчанию слушает только 127.0.0.1.
+class StatsServer {
+public:
+    static bool start(const std::string& address);
+    static void stop();
+
+private:
+    static void run();
+    static void serve(int client);
+
+    static int listenFd;
+    static std::atomic<bool> stopping;
+    static std::thread serverThread;
+};
+
+#endif // STATSSERVER_HPP
@@ -0,0 +1,112 @@
+// src/TimerWheel.hpp
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Иерархическое колесо таймеров: 4 уровня по 64 ячейки, единица времени — тик
+// (его длину выбирает владелец). Постановка — O(1), продвижение — O(1) на тик плюс
+// перенос ячейки верхнего уровня раз в 64^k тиков. Горизонт — 2^24 тиков; более
+// дальние сроки переносятся по кругу, пока не наступят.
+// Отмены нет: владелец сам отбрасывает устаревшие срабатывания (например, по поколению).
+template <typename T>
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t nowTick = 0) : current(nowTick) {}
+
+    // Срок в прошлом срабатывает при ближайшем advance()
+    void schedule(uint64_t dueTick, T value) {
+        insert(Entry{dueTick, std::move(value)});
+        ++count;
+    }
+
+    // Продвигает колесо до nowTick включительно, вызывая fire(value) для наступивших сроков
+    template <typename F>
+    void advance(uint64_t nowTick, F&& fire) {
+        if (!count) {
+            current = std::max(current, nowTick);
+            return;
+        }
+        while (current < nowTick) {
+            ++current;
+            // На границе оборота нижнего уровня опускаем ячейку следующего уровня
+            for (size_t level = 1; level < kLevels; ++level) {
+                if (current & ((uint64_t(1) << (kBits * level)) - 1))
+                    break;
+                cascade(level, (current >> (kBits * level)) & kMask);
+            }
+            fireSlot(slots[0][current & kMask], fire);
+            if (!count) {
+                current = nowTick;
+                break;
+            }
+        }
+        fireSlot(overdue, fire);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    uint64_t now() const { return current; }
+
+private:
+    static constexpr size_t   kLevels = 4;
+    static constexpr size_t   kBits = 6;
+    static constexpr size_t   kSlots = size_t(1) << kBits;
+    static constexpr uint64_t kMask = kSlots - 1;
+
+    struct Entry {
+        uint64_t due;
+        T        value;
+    };
+
+    void insert(Entry&& e) {
+        if (e.due <= current) {
+            overdue.push_back(std::move(e));
+            return;
+        }
+        uint64_t delta = e.due - current;
+        for (size_t level = 0; level < kLevels; ++level) {
+            if (delta < (uint64_t(1) << (kBits * (level + 1)))) {
+                slots[level][(e.due >> (kBits * level)) & kMask].push_back(std::move(e));
+                return;
+            }
+        }
+        // За горизонтом: кладём в самую дальнюю ячейку верхнего уровня
+        uint64_t far = current + (uint64_t(1) << (kBits * kLevels)) - 1;
+        slots[kLevels - 1][(far >> (kBits * (kLevels - 1))) & kMask].push_back(std::move(e));
+    }
+
+    void cascade(size_t level, uint64_t slot) {
+        std::vector<Entry> moved;
+        moved.swap(slots[level][slot]);
+        for (auto& e : moved)
+            insert(std::move(e));
+    }
+
+    template <typename F>
+    void fireSlot(std::vector<Entry>& slot, F& fire) {
+        if (slot.empty())
+            return;
+        std::vector<Entry> due;
+        due.swap(slot);
+        for (auto& e : due) {
+            if (e.due > current) {
+                insert(std::move(e)); // перенесён из-за горизонта — срок ещё не наступил
+                continue;
+            }
+            --count;
+            fire(e.value);
+        }
+    }
+
+    uint64_t current;
+    size_t count = 0;
+    std::vector<Entry> slots[kLevels][kSlots];
+    std::vector<Entry> overdue;
+};
+
+#endif // TIMERWHEEL_HPP
@@ -0,0 +1,569 @@
+// src/TransferPool.cpp
+#include "TransferPool.hpp"
+#include "Logger.hpp"
+#include "CurlShare.hpp"
+#include "MemoryBudget.hpp"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+namespace {
+// Шаг колёс повторов и сроков
+constexpr uint64_t kRetryTickMs = 10;
+// Как часто цикл просыпается ради сроков, если других событий нет
+constexpr int      kDeadlinePollMs = 100;
+
+// Записи CURLOPT_RESOLVE вида "+host:port:addr" (libcurl >= 7.75.0) живут в DNS-кэше
+// обычный срок. Без "+" запись постоянная: общий кэш рос бы на несколько записей
+// с каждым доменом, поэтому со старой libcurl найденный адрес не передаётся
+bool timedResolveEntries() {
+    static const bool supported = [] {
+        bool ok = curl_version_info(CURLVERSION_NOW)->version_num >= 0x074B00;
+        if (!ok)
+            Logger::info("TransferPool: libcurl < 7.75.0, адреса DnsResolver не передаются в curl");
+        return ok;
+    }();
+    return supported;
+}
+}
+
+TransferPool::TransferPool(size_t maxInFlight_, Engine engine_)
+    : engine(engine_)
+    , maxInFlight(maxInFlight_ ? maxInFlight_ : 1)
+    , epoch(std::chrono::steady_clock::now())
+    , rng(std::random_device{}())
+{
+    multi = curl_multi_init();
+    if (!multi) {
+        Logger::error("TransferPool: не удалось инициализировать curl_multi");
+        return;
+    }
+    // Не даём curl открывать больше соединений, чем слотов в окне
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(maxInFlight));
+    slots.reserve(maxInFlight);
+    idle.reserve(maxInFlight);
+
+    if (engine == Engine::Epoll) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (epollFd < 0 || timerFd < 0) {
+            Logger::error("TransferPool: epoll/timerfd недоступны (%s), переключаемся на poll",
+                          std::strerror(errno));
+            if (epollFd >= 0) ::close(epollFd);
+            if (timerFd >= 0) ::close(timerFd);
+            epollFd = timerFd = -1;
+            engine = Engine::Poll;
+            return;
+        }
+        // timerfd регистрируем с data.fd = -1, чтобы отличать его от сокетов curl
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = -1;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev);
+
+        curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, TransferPool::socketCallback);
+        curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, TransferPool::timerCallback);
+        curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+    }
+}
+
+TransferPool::~TransferPool() {
+    for (auto& t : slots) {
+        if (t->busy)
+            releaseTransfer(t.get());
+        if (t->easy)
+            curl_easy_cleanup(t->easy);
+        t->resp.dropBuffered();
+    }
+    if (multi)
+        curl_multi_cleanup(multi);
+    if (epollFd >= 0) ::close(epollFd);
+    if (timerFd >= 0) ::close(timerFd);
+}
+
+// curl сообщает, какие события нужны на сокете: переносим это в epoll
+int TransferPool::socketCallback(CURL*, curl_socket_t s, int what, void* userp, void* socketp) {
+    TransferPool* self = static_cast<TransferPool*>(userp);
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(self->epollFd, EPOLL_CTL_DEL, s, nullptr);
+        curl_multi_assign(self->multi, s, nullptr);
+        return 0;
+    }
+
+    epoll_event ev{};
+    ev.data.fd = s;
+    if (what & CURL_POLL_IN)  ev.events |= EPOLLIN;
+    if (what & CURL_POLL_OUT) ev.events |= EPOLLOUT;
+
+    // socketp != nullptr — сокет уже зарегистрирован в epoll
+    if (socketp) {
+        epoll_ctl(self->epollFd, EPOLL_CTL_MOD, s, &ev);
+    } else {
+        if (epoll_ctl(self->epollFd, EPOLL_CTL_ADD, s, &ev) != 0 && errno == EEXIST)
+            epoll_ctl(self->epollFd, EPOLL_CTL_MOD, s, &ev);
+        curl_multi_assign(self->multi, s, self);
+    }
+    return 0;
+}
+
+// curl просит вызвать его через timeoutMs миллисекунд (-1 — таймер не нужен)
+int TransferPool::timerCallback(CURLM*, long timeoutMs, void* userp) {
+    TransferPool* self = static_cast<TransferPool*>(userp);
+    itimerspec its{};
+    if (timeoutMs > 0) {
+        its.it_value.tv_sec  = timeoutMs / 1000;
+        its.it_value.tv_nsec = (timeoutMs % 1000) * 1000000L;
+    } else if (timeoutMs == 0) {
+        // Нулевой таймаут означает "как можно скорее": взводим таймер на 1 нс
+        its.it_value.tv_nsec = 1;
+    }
+    timerfd_settime(self->timerFd, 0, &its, nullptr);
+    return 0;
+}
+
+// Снимает хендл с multi; сам хендл остаётся у слота для следующей передачи
+void TransferPool::releaseTransfer(Transfer* t) {
+    curl_multi_remove_handle(multi, t->easy);
+    t->busy = false;
+    if (t->resolve) {
+        curl_slist_free_all(t->resolve);
+        t->resolve = nullptr;
+    }
+}
+
+uint64_t TransferPool::nowMs() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+uint64_t TransferPool::nowTick() const {
+    return nowMs() / kRetryTickMs;
+}
+
+bool TransferPool::addTransfer(const FetchRequest& req, int attempt, const Sink& done) {
+    const std::string& url = req.url;
+    Transfer* t = nullptr;
+    if (!idle.empty()) {
+        t = idle.back();
+        idle.pop_back();
+    } else {
+        slots.push_back(std::make_unique<Transfer>());
+        t = slots.back().get();
+    }
+    // Копия нужна повтору и fallback; присваивается всегда, иначе слот сохранил бы
+    // запрос прошлой передачи. Строки слота переиспользуют свою память
+    t->req = req;
+    t->attempt = attempt;
+    ++t->generation;
+    t->resp.recycle();
+    t->resp.url = url;
+    t->resp.ticket = req.ticket;
+    t->resp.retries = attempt;
+    t->resp.maxBytes = maxBytes;
+    t->resp.fellBack = req.fellBack;
+    if (matcher) {
+        t->resp.matcher = matcher;
+        matcher->reset(t->resp.matchState);
+    }
+    if (rules) {
+        t->resp.rules = rules;
+        t->resp.ruleCache = ruleCache.get();
+        rules->reset(t->resp.ruleState);
+    }
+
+    // Хендл слота переиспользуется: curl_easy_reset сбрасывает опции, но оставляет
+    // кэши хендла и не стоит аллокаций curl_easy_init
+    CURL* easy = t->easy;
+    if (easy) {
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+        if (!easy) {
+            Logger::error("TransferPool: не удалось инициализировать curl_easy для URL: %s", url.c_str());
+            idle.push_back(t);
+            done(t->resp);
+            return false;
+        }
+        t->easy = easy;
+    }
+
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    // Callback-и для тела и заголовков
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, HttpClient::writeCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &t->resp);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, HttpClient::headerCallback);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &t->resp);
+    // Сжатая передача: curl распаковывает поток до writeCallback, тело не буферизуется
+    if (compression)
+        curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+    // Разрешаем автоматическое перенаправление по Location
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_MAXREDIRS, 10L);
+    // Отключаем проверку SSL-сертификата
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 0L);
+    // Отключаем использование сигналов (для таймаутов)
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    // Адрес уже найден стадией DnsResolver: подставляем его для всех портов запроса
+    if (!req.address.empty() && !req.host.empty() && timedResolveEntries()) {
+        const int ports[] = {80, 443, req.port};
+        for (size_t i = 0; i < 3; ++i) {
+            int port = ports[i];
+            if (i == 2 && (port <= 0 || port == 80 || port == 443))
+                continue;
+            std::string entry = "+" + req.host + ":" + std::to_string(port) + ":" + req.address;
+            t->resolve = curl_slist_append(t->resolve, entry.c_str());
+        }
+        curl_easy_setopt(easy, CURLOPT_RESOLVE, t->resolve);
+    }
+    // Общие между потоками DNS-кэш и TLS-сессии
+    if (CURLSH* sh = CurlShare::handle())
+        curl_easy_setopt(easy, CURLOPT_SHARE, sh);
+    // Указатель на слот — для идентификации при завершении
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, t);
+
+    CURLMcode mc = curl_multi_add_handle(multi, easy);
+    if (mc != CURLM_OK) {
+        Logger::error("TransferPool: ошибка curl_multi_add_handle: %s", curl_multi_strerror(mc));
+        releaseTransfer(t);
+        idle.push_back(t);
+        done(t->resp);
+        return false;
+    }
+    t->busy = true;
+    ++active;
+
+    uint64_t now = nowMs();
+    t->startMs = now;
+    t->speedBaseline = 0;
+    t->speedStarted = false;
+    armPhaseCheck(t, now);
+    armSpeedCheck(t, now);
+    return true;
+}
+
+// Ставит в колесо ближайший ещё не проверенный срок фазы
+void TransferPool::armPhaseCheck(Transfer* t, uint64_t now) {
+    uint64_t elapsed = now - t->startMs;
+    uint64_t next = UINT64_MAX;
+    for (uint32_t limit : {deadlines.connectMs, deadlines.tlsMs, deadlines.firstByteMs, deadlines.totalMs}) {
+        if (limit && limit > elapsed)
+            next = std::min<uint64_t>(next, limit);
+    }
+    if (next != UINT64_MAX)
+        deadlineWheel.schedule((t->startMs + next + kRetryTickMs - 1) / kRetryTickMs,
+                               Check{t, t->generation, false});
+}
+
+void TransferPool::armSpeedCheck(Transfer* t, uint64_t now) {
+    if (!deadlines.minBytesPerSec || !deadlines.speedWindowMs)
+        return;
+    deadlineWheel.schedule((now + deadlines.speedWindowMs + kRetryTickMs - 1) / kRetryTickMs,
+                           Check{t, t->generation, true});
+}
+
+// Возвращает причину снятия передачи или Eviction::None (тогда проверка перевзведена)
+Eviction TransferPool::checkDeadline(const Check& c, uint64_t now) {
+    Transfer* t = c.t;
+    uint64_t elapsed = now - t->startMs;
+    curl_off_t connect = 0, pretransfer = 0, firstByte = 0;
+    curl_easy_getinfo(t->easy, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(t->easy, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(t->easy, CURLINFO_STARTTRANSFER_TIME_T, &firstByte);
+
+    if (c.speed) {
+        // До первого байта скорость не оцениваем — за это отвечает срок firstByteMs.
+        // Окно, в котором пришёл первый байт, неполное: с этого момента взводим целое
+        if (firstByte > 0 && t->speedStarted) {
+            size_t need = static_cast<size_t>(
+                static_cast<uint64_t>(deadlines.minBytesPerSec) * deadlines.speedWindowMs / 1000);
+            if (t->resp.progressBytes - t->speedBaseline < need)
+                return Eviction::LowSpeed;
+        }
+        t->speedStarted = firstByte > 0;
+        t->speedBaseline = t->resp.progressBytes;
+        armSpeedCheck(t, now);
+        return Eviction::None;
+    }
+
+    // Повторно использованное соединение даёт CONNECT_TIME 0, но PRETRANSFER > 0
+    if (deadlines.totalMs && elapsed >= deadlines.totalMs)
+        return Eviction::Total;
+    if (deadlines.connectMs && elapsed >= deadlines.connectMs && connect <= 0 && pretransfer <= 0)
+        return Eviction::Connect;
+    if (deadlines.tlsMs && elapsed >= deadlines.tlsMs && pretransfer <= 0)
+        return Eviction::Tls;
+    if (deadlines.firstByteMs && elapsed >= deadlines.firstByteMs && firstByte <= 0)
+        return Eviction::FirstByte;
+    armPhaseCheck(t, now);
+    return Eviction::None;
+}
+
+// Снимает передачи с истёкшими сроками; зовётся между шагами цикла
+void TransferPool::enforceDeadlines(const Sink& done) {
+    deadlineWheel.advance(nowTick(), [this](Check& c) { expired.push_back(c); });
+    if (expired.empty())
+        return;
+    uint64_t now = nowMs();
+    for (const Check& c : expired) {
+        Transfer* t = c.t;
+        if (!t->busy || t->generation != c.generation)
+            continue; // передача уже завершилась
+        Eviction why = checkDeadline(c, now);
+        if (why == Eviction::None)
+            continue;
+        t->resp.evicted = why;
+        ++evicted;
+        Logger::debug("URL: %s снят по сроку (причина %d) через %llu мс", t->resp.url.c_str(),
+                      static_cast<int>(why), static_cast<unsigned long long>(now - t->startMs));
+        finishTransfer(t, CURLE_OPERATION_TIMEDOUT, done);
+    }
+    expired.clear();
+}
+
+// https не ответил на этапе соединения или TLS: сразу повторяем запрос по http
+bool TransferPool::scheduleFallback(Transfer* t, CURLcode result) {
+    if (t->req.fallbackUrl.empty() || t->resp.aborted)
+        return false;
+    bool connectPhase = false;
+    switch (result) {
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_PEER_FAILED_VERIFICATION:
+    case CURLE_GOT_NOTHING:
+    case CURLE_RECV_ERROR:
+    case CURLE_SEND_ERROR:
+        connectPhase = t->resp.code == 0;
+        break;
+    case CURLE_OPERATION_TIMEDOUT:
+        connectPhase = t->resp.evicted == Eviction::Connect || t->resp.evicted == Eviction::Tls;
+        break;
+    default:
+        break;
+    }
+    if (!connectPhase)
+        return false;
+    Logger::debug("URL: %s не ответил (CURL код %d), пробуем %s", t->req.url.c_str(),
+                  static_cast<int>(result), t->req.fallbackUrl.c_str());
+    Retry r{std::move(t->req), t->attempt};
+    r.req.url = std::move(r.req.fallbackUrl);
+    r.req.fallbackUrl.clear();
+    r.req.fellBack = true;
+    dueRetries.push_back(std::move(r));
+    return true;
+}
+
+// Временная ошибка с остатком бюджета: запрос уходит в колесо вместо Sink
+bool TransferPool::scheduleRetry(Transfer* t, CURLcode result) {
+    if (!retryPolicy || t->resp.aborted || !retryPolicy->shouldRetry(t->attempt, result, t->resp.code))
+        return false;
+    long long retryAfter = -1;
+#if LIBCURL_VERSION_NUM >= 0x074200
+    curl_off_t ra = 0;
+    if (curl_easy_getinfo(t->easy, CURLINFO_RETRY_AFTER, &ra) == CURLE_OK && ra > 0)
+        retryAfter = static_cast<long long>(ra);
+#endif
+    uint32_t delay = retryPolicy->delayMs(t->attempt, retryAfter, rng);
+    Logger::debug("URL: %s повтор %d через %u мс (CURL код %d, HTTP код %ld)",
+                  t->req.url.c_str(), t->attempt + 1, delay, static_cast<int>(result), t->resp.code);
+    retryWheel.schedule(nowTick() + (delay + kRetryTickMs - 1) / kRetryTickMs,
+                        Retry{std::move(t->req), t->attempt + 1});
+    ++retried;
+    return true;
+}
+
+// Заполняет итог передачи, освобождает слот и отдаёт ответ в Sink (или ставит повтор)
+void TransferPool::finishTransfer(Transfer* t, CURLcode result, const Sink& done) {
+    CURL* easy = t->easy;
+    long http_code = 0;
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_code);
+    t->resp.code = http_code;
+    t->resp.result = t->resp.aborted ? CURLE_OK : result;
+    char* eff_url = nullptr;
+    curl_easy_getinfo(easy, CURLINFO_EFFECTIVE_URL, &eff_url);
+    t->resp.effectiveUrl.assign(eff_url ? eff_url : "");
+    curl_easy_getinfo(easy, CURLINFO_SIZE_DOWNLOAD_T, &t->resp.bytesReceived);
+    TransferTimings& tm = t->resp.timings;
+    curl_easy_getinfo(easy, CURLINFO_NAMELOOKUP_TIME_T, &tm.dns);
+    curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME_T, &tm.connect);
+    curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME_T, &tm.tls);
+    curl_easy_getinfo(easy, CURLINFO_STARTTRANSFER_TIME_T, &tm.ttfb);
+    curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &tm.total);
+    // У снятой передачи curl не успел обновить общее время
+    if (t->resp.evicted != Eviction::None)
+        tm.total = std::max<curl_off_t>(tm.total, static_cast<curl_off_t>(nowMs() - t->startMs) * 1000);
+    if (controller)
+        controller->onComplete(t->resp);
+    // Не найденное до конца передачи считается отсутствующим — если тело дошло целиком
+    // или передачу прервало решение слов и правил (но не бюджет, срок или ошибка)
+    if (rules) {
+        bool complete = !t->resp.truncated && t->resp.evicted == Eviction::None &&
+                        (t->resp.aborted || result == CURLE_OK);
+        rules->finish(t->resp.ruleState, complete);
+    }
+
+    // Снятые по сроку не повторяются: иначе медленный хост снова займёт слот
+    if (scheduleFallback(t, result) ||
+        (t->resp.evicted == Eviction::None && scheduleRetry(t, result))) {
+        releaseTransfer(t);
+        t->resp.dropBuffered();
+        --active;
+        idle.push_back(t);
+        return;
+    }
+    if (t->resp.truncated) {
+        Logger::debug("URL: %s прерван по бюджету %zu байт, HTTP код: %ld",
+                      t->resp.url.c_str(), maxBytes, http_code);
+    } else if (t->resp.aborted) {
+        Logger::debug("URL: %s прерван после совпадения, HTTP код: %ld, получено байт: %zu",
+                      t->resp.url.c_str(), http_code, t->resp.bodySize);
+    } else if (result != CURLE_OK) {
+        Logger::debug("URL: %s завершился ошибкой: %s (CURL код %d), HTTP код: %ld, получено байт: %zu",
+                      t->resp.url.c_str(), curl_easy_strerror(result),
+                      static_cast<int>(result), http_code, t->resp.bodySize);
+    } else {
+        Logger::debug("URL: %s успешно получен, HTTP код: %ld, размер: %zu байт",
+                      t->resp.url.c_str(), http_code, t->resp.bodySize);
+    }
+
+    releaseTransfer(t);
+    --active;
+
+    // Слот освобождаем до вызова Sink: тело ответа живёт до следующего addTransfer
+    idle.push_back(t);
+    done(t->resp);
+    // Результат обработан: буферы слота больше не считаются занятыми
+    t->resp.dropBuffered();
+}
+
+void TransferPool::drainCompleted(const Sink& done) {
+    int msgs_left = 0;
+    CURLMsg* msg = nullptr;
+    while ((msg = curl_multi_info_read(multi, &msgs_left))) {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        Transfer* t = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &t);
+        finishTransfer(t, msg->data.result, done);
+    }
+}
+
+void TransferPool::run(const Source& next, const Sink& done) {
+    if (!multi)
+        return;
+
+    bool exhausted = false;
+    FetchRequest req;
+    auto onDue = [this](Retry& r) { dueRetries.push_back(std::move(r)); };
+    while (true) {
+        // Наступившие повторы занимают окно раньше новых URL
+        retryWheel.advance(nowTick(), onDue);
+        while (!dueRetries.empty() && active < maxInFlight) {
+            addTransfer(dueRetries.front().req, dueRetries.front().attempt, done);
+            dueRetries.pop_front();
+        }
+        bool retriesPending = !retryWheel.empty() || !dueRetries.empty();
+
+        // Адаптивный предел окна: пересчитывается раз в интервал регулятора
+        if (controller && controller->update(nowMs())) {
+            maxInFlight = controller->limit();
+            curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(maxInFlight));
+        }
+
+        // Дозаполняем окно до maxInFlight, пока буферы всех потоков укладываются в бюджет
+        bool overBudget = !exhausted && active < maxInFlight && MemoryBudget::exceeded();
+        if (overBudget)
+            ++stalls;
+        while (!exhausted && active < maxInFlight && !overBudget) {
+            Pull p = next(req, active == 0 && !retriesPending);
+            if (p == Pull::Done) {
+                exhausted = true;
+            } else if (p == Pull::Empty) {
+                break;
+            } else {
+                addTransfer(req, 0, done);
+            }
+        }
+
+        if (controller)
+            controller->onWindow(active);
+
+        if (active == 0) {
+            if (exhausted && !retriesPending)
+                break;
+            if (!retriesPending && !overBudget)
+                continue;
+            // В полёте ничего нет: ждём срока ближайшего повтора или освобождения памяти
+            std::this_thread::sleep_for(std::chrono::milliseconds(kRetryTickMs));
+            continue;
+        }
+
+        // Если в окне есть свободные слоты, а источник ещё не исчерпан,
+        // просыпаемся чаще, чтобы подхватить новые URL
+        int timeoutMs = (exhausted || active >= maxInFlight) ? 1000 : 50;
+        if (retriesPending)
+            timeoutMs = std::min<int>(timeoutMs, static_cast<int>(kRetryTickMs));
+        if (!deadlineWheel.empty())
+            timeoutMs = std::min(timeoutMs, kDeadlinePollMs);
+        bool ok = (engine == Engine::Epoll) ? epollStep(timeoutMs) : pollStep(timeoutMs);
+        if (!ok)
+            break;
+        drainCompleted(done);
+        enforceDeadlines(done);
+    }
+}
+
+bool TransferPool::pollStep(int timeoutMs) {
+    CURLMcode mc = curl_multi_wait(multi, nullptr, 0, timeoutMs, nullptr);
+    if (mc != CURLM_OK) {
+        Logger::error("TransferPool: ошибка curl_multi_wait: %s", curl_multi_strerror(mc));
+        return false;
+    }
+    int still_running = 0;
+    mc = curl_multi_perform(multi, &still_running);
+    if (mc != CURLM_OK) {
+        Logger::error("TransferPool: ошибка curl_multi_perform: %s", curl_multi_strerror(mc));
+        return false;
+    }
+    return true;
+}
+
+bool TransferPool::epollStep(int timeoutMs) {
+    constexpr int kMaxEvents = 256;
+    epoll_event events[kMaxEvents];
+    int n = epoll_wait(epollFd, events, kMaxEvents, timeoutMs);
+    if (n < 0) {
+        if (errno == EINTR)
+            return true;
+        Logger::error("TransferPool: ошибка epoll_wait: %s", std::strerror(errno));
+        return false;
+    }
+
+    int still_running = 0;
+    for (int i = 0; i < n; ++i) {
+        CURLMcode mc;
+        if (events[i].data.fd == -1) {
+            // Сработал таймер curl: сбрасываем timerfd и даём curl обработать таймауты
+            uint64_t expirations = 0;
+            ssize_t r = ::read(timerFd, &expirations, sizeof(expirations));
+            (void)r;
+            mc = curl_multi_socket_action(multi, CURL_SOCKET_TIMEOUT, 0, &still_running);
+        } else {
+            int flags = 0;
+            if (events[i].events & EPOLLIN)  flags |= CURL_CSELECT_IN;
+            if (events[i].events & EPOLLOUT) flags |= CURL_CSELECT_OUT;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) flags |= CURL_CSELECT_ERR;
+            mc = curl_multi_socket_action(multi, events[i].data.fd, flags, &still_running);
+        }
+        if (mc != CURLM_OK) {
+            Logger::error("TransferPool: ошибка curl_multi_socket_action: %s", curl_multi_strerror(mc));
+            return false;
+        }
+    }
+    return true;
+}
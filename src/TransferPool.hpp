@@ -0,0 +1,191 @@
+// src/TransferPool.hpp
+#ifndef TRANSFERPOOL_HPP
+#define TRANSFERPOOL_HPP
+
+#include "HttpClient.hpp"
+#include "RetryPolicy.hpp"
+#include "ConcurrencyController.hpp"
+#include "TimerWheel.hpp"
+#include <curl/curl.h>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Запрос на загрузку одного URL
+struct FetchRequest {
+    std::string url;
+    std::string host;     // имя хоста из URL
+    int         port = 0; // явный порт из URL (0 — по умолчанию)
+    std::string address;  // заранее разрешённый IP (через CURLOPT_RESOLVE); пусто — резолвит curl
+    uint64_t    ticket = 0; // квота HostScheduler (переносится в HttpResponse)
+    std::string fallbackUrl; // куда идти, если url не ответил на этапе соединения/TLS (https -> http)
+    bool        fellBack = false;
+};
+
+// Долгоживущий пул передач одного потока ("скользящее окно").
+// Держит один постоянный CURLM и до maxInFlight одновременных запросов:
+// как только передача завершается, результат сразу отдаётся в Sink,
+// а освободившийся слот заполняется следующим URL из Source.
+// Временные ошибки (см. RetryPolicy) не отдаются в Sink сразу: запрос ждёт в колесе
+// таймеров своей задержки и возвращается в окно раньше новых URL.
+// Сроки фаз (Deadlines) проверяет сам цикл: у каждой передачи в колесе лежит не больше
+// двух записей — ближайший срок фазы и проверка скорости; просроченная передача
+// снимается и отдаётся в Sink с причиной в HttpResponse::evicted.
+class TransferPool {
+public:
+    // Результат запроса очередного URL у источника
+    enum class Pull { Ok, Empty, Done };
+
+    // Движок ожидания событий:
+    //   Epoll — curl_multi_socket_action + epoll + timerfd, пробуждение стоит O(готовых сокетов);
+    //   Poll  — curl_multi_wait/curl_multi_perform, каждое пробуждение обходит все передачи.
+    enum class Engine { Epoll, Poll };
+
+    // Источник запросов. wait == true — в полёте нет ни одной передачи,
+    // можно блокироваться до появления данных (Empty в этом случае не возвращается).
+    using Source = std::function<Pull(FetchRequest& req, bool wait)>;
+    // Приёмник результатов: вызывается по завершении каждой передачи
+    using Sink   = std::function<void(HttpResponse& resp)>;
+
+    // Сроки от начала передачи, мс (0 — не ограничено). Редиректы входят в общий счёт.
+    struct Deadlines {
+        uint32_t connectMs = 10000;    // TCP-соединение установлено
+        uint32_t tlsMs = 15000;        // соединение готово к запросу, включая TLS
+        uint32_t firstByteMs = 30000;  // получен первый байт ответа
+        uint32_t totalMs = 60000;      // передача завершена
+        uint32_t minBytesPerSec = 1024; // после первого байта: не меньше стольких байт/с...
+        uint32_t speedWindowMs = 10000; // ...в каждом окне такой длины
+    };
+
+    explicit TransferPool(size_t maxInFlight, Engine engine = Engine::Epoll);
+    ~TransferPool();
+
+    TransferPool(const TransferPool&) = delete;
+    TransferPool& operator=(const TransferPool&) = delete;
+
+    // Крутит цикл до тех пор, пока источник не вернёт Done и все передачи не завершатся
+    void run(const Source& next, const Sink& done);
+
+    size_t inFlight() const { return active; }
+
+    // Включает потоковый поиск слов: тела ответов не буферизуются
+    void setMatcher(const KeywordMatcher* m) { matcher = m; }
+    // Правила --rules: вычисляются по заголовкам и телу в том же проходе
+    void setRules(const RuleSet* r) {
+        rules = r;
+        ruleCache = r ? std::make_unique<RuleSet::Cache>(*r) : nullptr;
+    }
+    size_t ruleCacheFlushes() const { return ruleCache ? ruleCache->flushes() : 0; }
+
+    // Бюджет байт тела на ответ (0 — без ограничения)
+    void setMaxBytes(size_t n) { maxBytes = n; }
+    // Accept-Encoding со всеми поддерживаемыми curl кодировками; распаковка потоковая
+    void setCompression(bool on) { compression = on; }
+
+    // Включает повторы временных ошибок (nullptr — каждая передача завершается с первой попытки)
+    void setRetryPolicy(const RetryPolicy* p) { retryPolicy = p; }
+
+    size_t retriesScheduled() const { return retried; }
+
+    void setDeadlines(const Deadlines& d) { deadlines = d; }
+
+    // Адаптивный предел окна; исходное значение берётся из регулятора
+    void setController(ConcurrencyController* c) {
+        controller = c;
+        if (c) {
+            maxInFlight = c->limit();
+            curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(maxInFlight));
+        }
+    }
+    size_t limit() const { return maxInFlight; }
+    size_t evictedCount() const { return evicted; }
+    // Сколько раз дозаполнение окна откладывалось из-за MemoryBudget
+    size_t budgetStalls() const { return stalls; }
+
+private:
+    struct Transfer {
+        CURL*        easy = nullptr;     // живёт всё время жизни слота, между передачами — curl_easy_reset
+        bool         busy = false;       // слот занят передачей (хендл добавлен в multi)
+        curl_slist*  resolve = nullptr; // записи CURLOPT_RESOLVE для заранее разрешённого адреса
+        FetchRequest req;               // копия запроса — для повтора
+        int          attempt = 0;
+        uint32_t     generation = 0;    // отличает записи колеса сроков от прошлых передач слота
+        uint64_t     startMs = 0;
+        size_t       speedBaseline = 0; // progressBytes на начало окна скорости
+        bool         speedStarted = false; // первое окно скорости отсчитано от первого байта
+        HttpResponse resp;
+    };
+
+    // Проверка срока в колесе: фаза или скорость
+    struct Check {
+        Transfer* t;
+        uint32_t  generation;
+        bool      speed;
+    };
+
+    // Запрос, ожидающий повтора
+    struct Retry {
+        FetchRequest req;
+        int          attempt = 0;
+    };
+
+    bool addTransfer(const FetchRequest& req, int attempt, const Sink& done);
+    bool scheduleRetry(Transfer* t, CURLcode result);
+    bool scheduleFallback(Transfer* t, CURLcode result);
+    void finishTransfer(Transfer* t, CURLcode result, const Sink& done);
+    uint64_t nowMs() const;
+    uint64_t nowTick() const;
+    void armPhaseCheck(Transfer* t, uint64_t now);
+    void armSpeedCheck(Transfer* t, uint64_t now);
+    Eviction checkDeadline(const Check& c, uint64_t now);
+    void enforceDeadlines(const Sink& done);
+    void releaseTransfer(Transfer* t);
+    void drainCompleted(const Sink& done);
+
+    // Один шаг цикла ожидания для каждого из движков
+    bool pollStep(int timeoutMs);
+    bool epollStep(int timeoutMs);
+
+    // Callback-и curl multi для движка Epoll
+    static int socketCallback(CURL* easy, curl_socket_t s, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeoutMs, void* userp);
+
+    CURLM* multi = nullptr;
+    Engine engine;
+    int    epollFd = -1;
+    int    timerFd = -1;
+    size_t maxInFlight;
+    size_t active = 0;
+    const KeywordMatcher* matcher = nullptr;
+    const RuleSet* rules = nullptr;
+    std::unique_ptr<RuleSet::Cache> ruleCache;
+    size_t maxBytes = 0;
+    bool   compression = true;
+    // Все созданные слоты передач; свободные переиспользуются через idle
+    std::vector<std::unique_ptr<Transfer>> slots;
+    std::vector<Transfer*> idle;
+
+    // Повторы: колесо с шагом kRetryTickMs и очередь наступивших
+    const RetryPolicy* retryPolicy = nullptr;
+    std::chrono::steady_clock::time_point epoch;
+    TimerWheel<Retry> retryWheel;
+    std::deque<Retry> dueRetries;
+    std::minstd_rand rng;
+    size_t retried = 0;
+    size_t stalls = 0;
+
+    // Сроки передач: колесо с тем же шагом
+    Deadlines deadlines;
+    TimerWheel<Check> deadlineWheel;
+    std::vector<Check> expired;
+    size_t evicted = 0;
+
+    ConcurrencyController* controller = nullptr;
+};
+
+#endif // TRANSFERPOOL_HPP
@@ -2,39 +2,76 @@
 #include "Worker.hpp"
 #include "HttpClient.hpp"
 #include "Logger.hpp"
+#include "ResultWriter.hpp"
+#include "Journal.hpp"
+#include "Metrics.hpp"
+#include "Sharding.hpp"
 #include <algorithm>
-#include <cctype>
 
-std::queue<std::string>  Worker::domainQueue;
-bool                     Worker::loadingDone = false;
-std::mutex               Worker::queueMutex;
-std::condition_variable  Worker::condVar;
+std::unique_ptr<BoundedQueue<DomainTask>> Worker::domainQueue =
+    std::make_unique<BoundedQueue<DomainTask>>(65536);
+const MappedInput*       Worker::mappedInput = nullptr;
+std::vector<MappedInput::Range> Worker::shards;
 std::vector<std::thread> Worker::threads;
-FILE*                    Worker::outputFile = nullptr;
-std::mutex               Worker::outputMutex;
+size_t                   Worker::threadCount = 0;
 std::vector<std::string> Worker::matchWords;
+KeywordMatcher           Worker::matcher;
+RuleSet                  Worker::rules;
+size_t                   Worker::concurrency = 200;
+bool                     Worker::adaptive = false;
+size_t                   Worker::maxConcurrency = 2000;
+TransferPool::Engine     Worker::engine = TransferPool::Engine::Epoll;
+ResultFormat::Format     Worker::outputFormat = ResultFormat::Format::Plain;
+std::function<void(uint64_t)> Worker::completionSink;
+RetryPolicy              Worker::retryPolicy;
+TransferPool::Deadlines  Worker::deadlines;
+Worker::Scheme           Worker::scheme = Worker::Scheme::Http;
+size_t                   Worker::maxBytes = 0;
+bool                     Worker::compression = true;
 
-void Worker::startThreads(int count, FILE* outfp) {
-    outputFile = outfp;
+// Курсор по своему диапазону отображённого файла (режим mmap)
+static thread_local MappedInput::Cursor shardCursor;
+// Строки диапазона, принадлежащие другим узлам (--shard)
+static thread_local size_t foreignLines = 0;
+
+namespace {
+// Наблюдения режима Scheme::Auto (по потоку): скользящие доли
+//   redirectRate — ответы на http://, пришедшие в итоге на https (лишний RTT у http-first);
+//   fallbackRate — запросы https://, откатившиеся на http (лишняя попытка у https-first).
+// Каждый 16-й домен идёт другой стратегией, чтобы оценка не устаревала.
+struct SchemeLearner {
+    double   redirectRate = 0.6;
+    double   fallbackRate = 0.2;
+    uint32_t counter = 0;
+};
+thread_local SchemeLearner schemeLearner;
+constexpr double   kLearnRate = 0.05;
+constexpr uint32_t kExploreEvery = 16;
+}
+
+void Worker::startThreads(int count) {
+    if (mappedInput)
+        shards = mappedInput->split(static_cast<size_t>(count));
+    threadCount = static_cast<size_t>(count);
     for (int i = 0; i < count; ++i) {
-        threads.emplace_back(Worker());
+        threads.emplace_back(Worker(static_cast<size_t>(i)));
     }
 }
 
 void Worker::enqueueDomain(const std::string& domain) {
-    {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        domainQueue.push(domain);
-    }
-    condVar.notify_one();
+    enqueueTask(DomainTask{domain, std::string()});
+}
+
+void Worker::enqueueTask(DomainTask&& task) {
+    domainQueue->push(std::move(task));
+}
+
+bool Worker::tryEnqueueTask(DomainTask&& task) {
+    return domainQueue->tryPush(std::move(task));
 }
 
 void Worker::notifyFinished() {
-    {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        loadingDone = true;
-    }
-    condVar.notify_all();
+    domainQueue->close();
 }
 
 void Worker::joinThreads() {
@@ -46,92 +83,261 @@ void Worker::joinThreads() {
 
 void Worker::setMatchWords(const std::vector<std::string>& words) {
     matchWords = words;
+    // Автомат компилируется один раз и разделяется всеми потоками (только чтение)
+    matcher.compile(words);
 }
 
-void Worker::operator()() {
-    static std::once_flag onceFlag;
-    std::call_once(onceFlag, []() {
-        Logger::debug("Worker: searching for words:");
-        for (const auto& w : matchWords) {
-            Logger::debug("  - %s", w.c_str());
-        }
-    });
+void Worker::setRules(RuleSet&& r) {
+    rules = std::move(r);
+}
 
-    HttpClient client;
-    const int batchSize = 5;  // Можно увеличить при необходимости
+void Worker::setConcurrency(size_t perThread) {
+    concurrency = perThread;
+}
 
-    while (true) {
-        std::vector<std::string> batchDomains;
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            condVar.wait(lock, [] {
-                return !domainQueue.empty() || loadingDone;
-            });
+void Worker::setAdaptiveConcurrency(size_t initial, size_t maxPerThread) {
+    adaptive = true;
+    concurrency = initial;
+    maxConcurrency = maxPerThread;
+}
 
-            if (domainQueue.empty() && loadingDone)
-                break;
+void Worker::setEngine(TransferPool::Engine e) {
+    engine = e;
+}
+
+void Worker::setQueueCapacity(size_t capacity) {
+    domainQueue = std::make_unique<BoundedQueue<DomainTask>>(capacity);
+}
+
+void Worker::setMappedInput(const MappedInput* input) {
+    mappedInput = input;
+}
 
-            for (int i = 0; i < batchSize && !domainQueue.empty(); ++i) {
-                std::string domain = std::move(domainQueue.front());
-                domainQueue.pop();
+void Worker::setOutputFormat(ResultFormat::Format f) {
+    outputFormat = f;
+}
 
-                domain.erase(std::remove(domain.begin(), domain.end(), '\r'), domain.end());
-                domain.erase(std::remove(domain.begin(), domain.end(), '\n'), domain.end());
+void Worker::setRetryPolicy(const RetryPolicy::Settings& settings) {
+    retryPolicy = RetryPolicy(settings);
+}
+
+void Worker::setDeadlines(const TransferPool::Deadlines& d) {
+    deadlines = d;
+}
 
-                batchDomains.push_back(std::move(domain));
+void Worker::setCompletionSink(std::function<void(uint64_t ticket)> sink) {
+    completionSink = std::move(sink);
+}
+
+void Worker::setScheme(Scheme s) {
+    scheme = s;
+}
+
+void Worker::setMaxBytes(size_t n) {
+    maxBytes = n;
+}
+
+void Worker::setCompression(bool on) {
+    compression = on;
+}
+
+bool Worker::preferHttps() {
+    if (scheme != Scheme::Auto)
+        return scheme == Scheme::HttpsFirst;
+    SchemeLearner& l = schemeLearner;
+    bool https = l.fallbackRate < l.redirectRate;
+    if (++l.counter % kExploreEvery == 0)
+        https = !https;
+    return https;
+}
+
+void Worker::learnScheme(const HttpResponse& resp) {
+    if (scheme != Scheme::Auto)
+        return;
+    SchemeLearner& l = schemeLearner;
+    if (resp.fellBack || resp.url.rfind("https://", 0) == 0) {
+        l.fallbackRate += kLearnRate * ((resp.fellBack ? 1.0 : 0.0) - l.fallbackRate);
+    } else if (resp.code > 0) {
+        bool redirected = resp.effectiveUrl.rfind("https://", 0) == 0;
+        l.redirectRate += kLearnRate * ((redirected ? 1.0 : 0.0) - l.redirectRate);
+    }
+}
+
+void Worker::buildRequest(std::string_view domain, std::string&& address, FetchRequest& req) {
+    splitHostPort(domain, req.host, req.port);
+    req.address = std::move(address);
+    req.fallbackUrl.clear();
+    req.fellBack = false;
+    // Добавляем протокол, если его нет; буферы req.url/fallbackUrl переиспользуются между запросами.
+    // С явным нестандартным портом https не пробуем: это почти всегда http-сервис.
+    if (domain.find("://") != std::string_view::npos) {
+        req.url.assign(domain.data(), domain.size());
+    } else if ((req.port == 0 || req.port == 443) && preferHttps()) {
+        req.url.assign("https://").append(domain.data(), domain.size());
+        req.fallbackUrl.assign("http://").append(domain.data(), domain.size());
+    } else {
+        req.url.assign("http://").append(domain.data(), domain.size());
+    }
+}
+
+// Пул текущего потока: окно передач для метрики crawler_in_flight
+static thread_local const TransferPool* currentPool = nullptr;
+
+size_t Worker::queueDepth() {
+    return mappedInput ? 0 : domainQueue->sizeApprox();
+}
+
+TransferPool::Pull Worker::nextRequest(FetchRequest& req, bool wait) {
+    Metrics::setInFlight(currentPool->inFlight());
+    if (mappedInput) {
+        std::string_view line;
+        uint64_t offset = 0;
+        while (true) {
+            if (!shardCursor.next(line, offset))
+                return TransferPool::Pull::Done;
+            if (!Sharding::owns(line)) {
+                ++foreignLines;
+                continue;
             }
+            if (!Journal::isDone(line))
+                break;
         }
+        buildRequest(line, std::string(), req);
+        req.ticket = 0;
+        return TransferPool::Pull::Ok;
+    }
 
-        if (batchDomains.empty())
-            continue;
-
-        // Добавляем протокол, если его нет
-        std::vector<std::string> urlsWithProtocol;
-        urlsWithProtocol.reserve(batchDomains.size());
-        for (const auto& domain : batchDomains) {
-            if (domain.find("://") == std::string::npos) {
-                urlsWithProtocol.push_back("http://" + domain);
-            } else {
-                urlsWithProtocol.push_back(domain);
-            }
+    // Домены забираются из общей очереди пачками в локальный буфер потока
+    constexpr size_t kBulk = 32;
+    thread_local std::vector<DomainTask> local(kBulk);
+    thread_local size_t localPos = 0, localSize = 0;
+
+    DomainTask task;
+    while (task.domain.empty()) {
+        if (localPos < localSize) {
+            task = std::move(local[localPos++]);
+        } else {
+            localPos = 0;
+            localSize = domainQueue->tryPopBulk(local.data(), kBulk);
+            if (localSize)
+                continue;
+            if (!wait)
+                return domainQueue->isClosed() && domainQueue->sizeApprox() == 0
+                    ? TransferPool::Pull::Done : TransferPool::Pull::Empty;
+            if (!domainQueue->pop(task))
+                return TransferPool::Pull::Done;
+        }
+        std::string& domain = task.domain;
+        domain.erase(std::remove(domain.begin(), domain.end(), '\r'), domain.end());
+        domain.erase(std::remove(domain.begin(), domain.end(), '\n'), domain.end());
+        if (task.unresolvable && !domain.empty()) {
+            reportUnresolvable(domain);
+            domain.clear();
         }
+    }
 
-        // Получаем результаты пачкой из HttpClient (параллельно)
-        auto results = client.fetchMulti(urlsWithProtocol);
+    buildRequest(task.domain, std::move(task.address), req);
+    req.ticket = task.ticket;
+    return TransferPool::Pull::Ok;
+}
 
-        // results: std::vector<HttpResponse>
-        for (const auto& resp : results) {
-            // Убираем протокол из URL для вывода
-            std::string domain = resp.url;
-            auto pos = domain.find("://");
-            if (pos != std::string::npos) {
-                domain = domain.substr(pos + 3);
-            }
+void Worker::handleResponse(const HttpResponse& resp) {
+    // Убираем протокол из URL для вывода
+    std::string_view domain = resp.url;
+    auto pos = domain.find("://");
+    if (pos != std::string_view::npos) {
+        domain.remove_prefix(pos + 3);
+    }
 
-            Logger::debug("Body length for %s (--> %zu <--)", domain.c_str(), resp.body.size());
-            std::string body_lower = resp.body;
-            std::transform(body_lower.begin(), body_lower.end(), body_lower.begin(), ::tolower);
-
-            bool matched = true;
-            for (const auto& word : matchWords) {
-                std::string word_lower = word;
-                std::transform(word_lower.begin(), word_lower.end(), word_lower.begin(), ::tolower);
-                if (body_lower.find(word_lower) == std::string::npos) {
-                    matched = false;
-                    break;
-                }
-            }
+    Logger::debug("Body length for %.*s (--> %zu <--)", static_cast<int>(domain.size()), domain.data(), resp.bodySize);
+    // С правилами совпадением считается хотя бы одно сработавшее правило
+    bool matched = matcher.matched(resp.matchState) &&
+                   (!resp.rules || resp.rules->anyMatched(resp.ruleState));
+    learnScheme(resp);
+    Metrics::record(resp, matched);
+    Metrics::setInFlight(currentPool->inFlight());
 
-            if (matched) {
-                std::lock_guard<std::mutex> lock(outputMutex);
-                if (outputFile) {
-                    std::fprintf(outputFile, "%s\n", domain.c_str());
-                    std::fflush(outputFile);
-                }
-                Logger::debug("Worker: matched all words in domain %s", domain.c_str());
-            } else {
-                Logger::debug("Worker: not matched %s", domain.c_str());
-            }
+    // Запись формируется в буфере потока и целиком передаётся писателю
+    thread_local std::string record;
+    record.clear();
+    ResultFormat::append(outputFormat, domain, resp, matcher, matched, record);
+    if (!record.empty())
+        ResultWriter::write(record);
+    Journal::markDone(domain);
+    if (resp.ticket && completionSink)
+        completionSink(resp.ticket);
+
+    if (matched) {
+        Logger::debug("Worker: matched all words in domain %.*s", static_cast<int>(domain.size()), domain.data());
+    } else {
+        Logger::debug("Worker: not matched %.*s", static_cast<int>(domain.size()), domain.data());
+    }
+}
+
+void Worker::reportUnresolvable(const std::string& domain) {
+    // Ответ заполняется так же, как у передачи, завершившейся ошибкой разрешения имени:
+    // одна запись на домен в структурированном выводе и отметка в журнале для --resume
+    thread_local HttpResponse resp;
+    resp = HttpResponse();
+    resp.url = domain;
+    resp.result = CURLE_COULDNT_RESOLVE_HOST;
+    if (!matchWords.empty()) {
+        resp.matcher = &matcher;
+        matcher.reset(resp.matchState);
+    }
+    if (const RuleSet* r = ruleSet()) {
+        resp.rules = r;
+        r->reset(resp.ruleState);
+        r->finish(resp.ruleState);
+    }
+    handleResponse(resp);
+}
+
+void Worker::operator()() {
+    static std::once_flag onceFlag;
+    std::call_once(onceFlag, []() {
+        Logger::debug("Worker: searching for words:");
+        for (const auto& w : matchWords) {
+            Logger::debug("  - %s", w.c_str());
         }
+    });
+
+    if (mappedInput)
+        shardCursor = mappedInput->cursor(shards[shard]);
+    // Постоянный пул передач потока: новые домены подхватываются по мере
+    // завершения старых, без ожидания всей пачки
+    TransferPool pool(concurrency, engine);
+    pool.setMatcher(&matcher);
+    pool.setRules(ruleSet());
+    pool.setRetryPolicy(&retryPolicy);
+    pool.setDeadlines(deadlines);
+    pool.setMaxBytes(maxBytes);
+    pool.setCompression(compression);
+    std::unique_ptr<ConcurrencyController> controller;
+    if (adaptive) {
+        ConcurrencyController::Settings cs;
+        cs.maxLimit = std::min(maxConcurrency, ConcurrencyController::resourceCap(threadCount));
+        cs.initial = std::min(concurrency, cs.maxLimit);
+        controller = std::make_unique<ConcurrencyController>(cs);
+        pool.setController(controller.get());
     }
-}
\ No newline at end of file
+    currentPool = &pool;
+    pool.run(
+        [](FetchRequest& req, bool wait) { return nextRequest(req, wait); },
+        [](HttpResponse& resp) { handleResponse(resp); });
+    currentPool = nullptr;
+    Metrics::setInFlight(0);
+    Sharding::addSkipped(foreignLines);
+    if (controller)
+        Logger::info("Worker %zu: адаптивный предел окна остановился на %zu (последнее значение %zu)",
+                     shard, controller->settled(), controller->limit());
+    if (pool.ruleCacheFlushes())
+        Logger::info("Worker %zu: кэш автоматов правил переполнялся %zu раз",
+                     shard, pool.ruleCacheFlushes());
+    if (pool.budgetStalls())
+        Logger::info("Worker %zu: дозаполнение окна откладывалось из-за бюджета памяти %zu раз",
+                     shard, pool.budgetStalls());
+    if (pool.retriesScheduled() || pool.evictedCount())
+        Logger::info("Worker %zu: повторов %zu, снято по срокам %zu",
+                     shard, pool.retriesScheduled(), pool.evictedCount());
+}
@@ -2,34 +2,95 @@
 #ifndef WORKER_HPP
 #define WORKER_HPP
 
+#include <functional>
 #include <string>
-#include <queue>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
-#include <condition_variable>
+#include "TransferPool.hpp"
+#include "KeywordMatcher.hpp"
+#include "RuleSet.hpp"
+#include "DomainTask.hpp"
+#include "BoundedQueue.hpp"
+#include "MappedInput.hpp"
+#include "ResultFormat.hpp"
 
 class Worker {
 public:
+    // Схема для доменов без явного протокола:
+    //   Http       — только http:// (как раньше);
+    //   HttpsFirst — https://, при отказе соединения/TLS — http://;
+    //   Auto       — поток выбирает между ними по наблюдаемой доле редиректов http->https
+    //                и доле откатов https->http.
+    enum class Scheme { Http, HttpsFirst, Auto };
+
     Worker() = default;
+    explicit Worker(size_t shard) : shard(shard) {}
     void operator()();
 
-    static void startThreads(int count, FILE* outfp);
+    static void startThreads(int count);
     static void enqueueDomain(const std::string& domain);
+    static void enqueueTask(DomainTask&& task);
+    // Неблокирующая постановка: false — очередь заполнена
+    static bool tryEnqueueTask(DomainTask&& task);
     static void notifyFinished();
     static void joinThreads();
     static void setMatchWords(const std::vector<std::string>& words);
-
-    static std::mutex outputMutex;
+    static void setConcurrency(size_t perThread);
+    // --concurrency=auto: предел окна подбирает ConcurrencyController (maxPerThread — потолок)
+    static void setAdaptiveConcurrency(size_t initial, size_t maxPerThread);
+    static void setEngine(TransferPool::Engine e);
+    // Ёмкость очереди доменов; вызывается до запуска загрузчика
+    static void setQueueCapacity(size_t capacity);
+    // Режим --input-mode=mmap: каждый поток читает свой диапазон файла, очередь не используется
+    static void setMappedInput(const MappedInput* input);
+    static void setOutputFormat(ResultFormat::Format f);
+    static void setRetryPolicy(const RetryPolicy::Settings& settings);
+    static void setDeadlines(const TransferPool::Deadlines& d);
+    static void setScheme(Scheme s);
+    static void setMaxBytes(size_t n);
+    static void setCompression(bool on);
+    static const KeywordMatcher& keywordMatcher() { return matcher; }
+    // --rules: набор правил компилируется один раз и разделяется всеми потоками
+    static void setRules(RuleSet&& r);
+    static const RuleSet* ruleSet() { return rules.empty() ? nullptr : &rules; }
+    // Приблизительная глубина очереди доменов (для метрик)
+    static size_t queueDepth();
+    // Вызывается по завершении каждой передачи с ticket задачи (возврат квоты HostScheduler)
+    static void setCompletionSink(std::function<void(uint64_t ticket)> sink);
 
 private:
-    static std::queue<std::string> domainQueue;
-    static bool loadingDone;
-    static std::mutex queueMutex;
-    static std::condition_variable condVar;
+    static TransferPool::Pull nextRequest(FetchRequest& req, bool wait);
+    static void buildRequest(std::string_view domain, std::string&& address, FetchRequest& req);
+    static bool preferHttps();
+    static void learnScheme(const HttpResponse& resp);
+
+    size_t shard = 0;
+    static void handleResponse(const HttpResponse& resp);
+    // Результат без передачи для домена, которого нет в DNS (CURLE_COULDNT_RESOLVE_HOST)
+    static void reportUnresolvable(const std::string& domain);
+
+    // Ограниченная очередь: загрузчик блокируется, когда воркеры не успевают
+    static std::unique_ptr<BoundedQueue<DomainTask>> domainQueue;
+    static const MappedInput* mappedInput;
+    static std::vector<MappedInput::Range> shards;
     static std::vector<std::thread> threads;
-    static FILE* outputFile;
+    static size_t threadCount;
     static std::vector<std::string> matchWords;
+    static KeywordMatcher matcher;
+    static RuleSet rules;
+    static size_t concurrency;
+    static bool adaptive;
+    static size_t maxConcurrency;
+    static TransferPool::Engine engine;
+    static ResultFormat::Format outputFormat;
+    static RetryPolicy retryPolicy;
+    static TransferPool::Deadlines deadlines;
+    static Scheme scheme;
+    static size_t maxBytes;
+    static bool compression;
+    static std::function<void(uint64_t)> completionSink;
 };
 
 #endif // WORKER_HPP
@@ -0,0 +1,145 @@
+// tests/CaseSearchTest.cpp
+// CaseSearch: векторные реализации против скалярной на случайных данных (байты >= 0x80
+// и соседи букв '@', '[', '`', '{', на которых ломается приведение регистра через | 0x20).
+// KeywordMatcher: подача тела кусками случайной длины прямым поиском и автоматом.
+#include "Check.hpp"
+#include "CaseSearch.hpp"
+#include "KeywordMatcher.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Алфавит с ловушками: заглавные и строчные буквы, их соседи по таблице ASCII
+// и байты, у которых после | 0x20 получается другой байт >= 0x80
+const char kAlphabet[] = "aAbBzZ@[`{\xC1\xE1\x80\xFF";
+
+char lowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string randomText(std::mt19937& rng, size_t len) {
+    std::uniform_int_distribution<int> pick(0, sizeof(kAlphabet) - 2);
+    std::uniform_int_distribution<int> any(0, 255);
+    std::string s(len, '\0');
+    for (char& c : s)
+        c = rng() % 8 ? kAlphabet[pick(rng)] : static_cast<char>(any(rng));
+    return s;
+}
+
+// Эталон: наивный регистронезависимый поиск
+size_t naiveFind(const std::string& hay, const std::string& needle) {
+    if (needle.size() > hay.size())
+        return CaseSearch::npos;
+    for (size_t i = 0; i + needle.size() <= hay.size(); ++i) {
+        size_t j = 0;
+        while (j < needle.size() && lowerAscii(hay[i + j]) == needle[j])
+            ++j;
+        if (j == needle.size())
+            return i;
+    }
+    return CaseSearch::npos;
+}
+
+// Игла — чаще кусок самой строки (чтобы совпадения были), иначе случайная
+std::string randomNeedle(std::mt19937& rng, const std::string& hay, size_t maxLen) {
+    size_t len = 1 + rng() % maxLen;
+    std::string needle;
+    if (hay.size() >= len && rng() % 3) {
+        size_t at = rng() % (hay.size() - len + 1);
+        needle = hay.substr(at, len);
+    } else {
+        needle = randomText(rng, len);
+    }
+    std::transform(needle.begin(), needle.end(), needle.begin(), lowerAscii);
+    return needle;
+}
+
+void testFind() {
+    std::mt19937 rng(12345);
+    const CaseSearch::Impl vectorImpls[] = {CaseSearch::Impl::Sse2, CaseSearch::Impl::Avx2};
+    for (int iter = 0; iter < 20000; ++iter) {
+        std::string hay = randomText(rng, rng() % 300);
+        std::string needle = randomNeedle(rng, hay, iter % 4 ? 8 : 70);
+        // Смещение внутри буфера: векторные версии не должны зависеть от выравнивания
+        size_t shift = rng() % 32;
+        std::string buf = std::string(shift, 'a') + hay;
+        const char* h = buf.data() + shift;
+
+        size_t expected = naiveFind(hay, needle);
+        CHECK(CaseSearch::find(CaseSearch::Impl::Scalar, h, hay.size(), needle.data(), needle.size()) == expected);
+        for (CaseSearch::Impl impl : vectorImpls) {
+            if (!CaseSearch::supported(impl))
+                continue;
+            CHECK(CaseSearch::find(impl, h, hay.size(), needle.data(), needle.size()) == expected);
+        }
+    }
+
+    // Пустая игла и игла длиннее строки
+    for (CaseSearch::Impl impl : {CaseSearch::Impl::Scalar, CaseSearch::Impl::Sse2, CaseSearch::Impl::Avx2}) {
+        CHECK(CaseSearch::find(impl, "abc", 3, "", 0) ==
+              CaseSearch::find(CaseSearch::Impl::Scalar, "abc", 3, "", 0));
+        CHECK(CaseSearch::find(impl, "ab", 2, "abc", 3) == CaseSearch::npos);
+    }
+}
+
+// Длина префикса тела, в котором найдены все слова (npos — не найдены)
+size_t decisionPoint(const std::vector<std::string>& words, const std::string& body) {
+    size_t point = 0;
+    for (const std::string& w : words) {
+        std::string lower = w;
+        std::transform(lower.begin(), lower.end(), lower.begin(), lowerAscii);
+        size_t at = naiveFind(body, lower);
+        if (at == CaseSearch::npos)
+            return CaseSearch::npos;
+        point = std::max(point, at + lower.size());
+    }
+    return point;
+}
+
+void testMatcher() {
+    std::mt19937 rng(777);
+    for (int iter = 0; iter < 3000; ++iter) {
+        std::string body = randomText(rng, rng() % 2000);
+        // До kDirectMaxWords слов выбирается прямой поиск, больше — автомат; проверяем оба
+        size_t count = 1 + rng() % (iter % 2 ? KeywordMatcher::kDirectMaxWords : 40);
+        std::vector<std::string> words;
+        for (size_t i = 0; i < count; ++i) {
+            std::string w = rng() % 2 ? randomNeedle(rng, body, 12) : randomText(rng, 1 + rng() % 4);
+            if (rng() % 2)
+                std::transform(w.begin(), w.end(), w.begin(),
+                               [](char c) { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c; });
+            words.push_back(w);
+        }
+        KeywordMatcher matcher(words);
+        size_t point = decisionPoint(words, body);
+
+        for (bool direct : {true, false}) {
+            matcher.setDirect(direct);
+            KeywordMatcher::State st;
+            matcher.reset(st);
+            size_t pos = 0;
+            bool decided = false;
+            while (pos < body.size() && !decided) {
+                size_t chunk = std::min(body.size() - pos, size_t(1 + rng() % (rng() % 4 ? 16 : 300)));
+                decided = matcher.feed(st, body.data() + pos, chunk);
+                // Решение принимается на первом куске, после которого найдены все слова
+                CHECK(decided == (pos + chunk >= point));
+                pos += chunk;
+            }
+            CHECK(matcher.matched(st) == (point != CaseSearch::npos));
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    testFind();
+    testMatcher();
+    if (checkFailures() == 0)
+        std::printf("CaseSearchTest: OK\n");
+    return checkFailures();
+}
@@ -0,0 +1,22 @@
+// tests/Check.hpp
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <cstdio>
+
+// Проверки без тестового фреймворка: каждый тест — отдельный исполняемый файл
+// (ctest), провалившаяся проверка печатается, код выхода — число провалов
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++checkFailures();                                                        \
+        }                                                                             \
+    } while (0)
+
+#endif // CHECK_HPP
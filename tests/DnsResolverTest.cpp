@@ -0,0 +1,216 @@
+// tests/DnsResolverTest.cpp
+// DnsResolver против локального DNS-заглушки: разбор ответов (сжатые имена, CNAME,
+// NXDOMAIN, SERVFAIL, обрезанные пакеты), отбрасывание поддельных ответов с чужим ID,
+// чужим вопросом или с другого порта, новые ID при повторах.
+#include "Check.hpp"
+#include "DnsResolver.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+void put16(std::string& out, unsigned v) {
+    out.push_back(static_cast<char>(v >> 8));
+    out.push_back(static_cast<char>(v & 0xFF));
+}
+
+void put32(std::string& out, uint32_t v) {
+    put16(out, v >> 16);
+    put16(out, v & 0xFFFF);
+}
+
+std::string encode(const std::string& name) {
+    std::string out;
+    size_t start = 0;
+    while (start < name.size()) {
+        size_t dot = name.find('.', start);
+        if (dot == std::string::npos)
+            dot = name.size();
+        out.push_back(static_cast<char>(dot - start));
+        out.append(name, start, dot - start);
+        start = dot + 1;
+    }
+    out.push_back('\0');
+    return out;
+}
+
+// Ответ: заголовок, вопрос (копия из запроса или question) и записи answers
+std::string reply(unsigned id, unsigned rcode, const std::string& question, unsigned ancount,
+                  const std::string& answers) {
+    std::string out;
+    put16(out, id);
+    put16(out, 0x8180 | rcode);
+    put16(out, 1);
+    put16(out, ancount);
+    put16(out, 0);
+    put16(out, 0);
+    return out + question + answers;
+}
+
+// A-запись для имени по смещению offset (указатель сжатия)
+std::string aRecord(unsigned offset, const char* ip) {
+    std::string out;
+    put16(out, 0xC000 | offset);
+    put16(out, 1);
+    put16(out, 1);
+    put32(out, 60);
+    put16(out, 4);
+    in_addr a;
+    inet_pton(AF_INET, ip, &a);
+    out.append(reinterpret_cast<const char*>(&a), 4);
+    return out;
+}
+
+class StubServer {
+public:
+    StubServer() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        other = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+        bind(other, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+        socklen_t len = sizeof(sa);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+        port = ntohs(sa.sin_port);
+        thread = std::thread(&StubServer::run, this);
+    }
+
+    ~StubServer() {
+        stopping = true;
+        thread.join();
+        close(fd);
+        close(other);
+    }
+
+    uint16_t port = 0;
+    std::mutex mtx;
+    std::map<std::string, std::vector<unsigned>> ids; // имя -> DNS ID всех попыток
+
+private:
+    void send(int from, const std::string& msg, const sockaddr_in& to) {
+        sendto(from, msg.data(), msg.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+    }
+
+    void run() {
+        unsigned char buf[512];
+        while (!stopping) {
+            pollfd pfd{fd, POLLIN, 0};
+            if (poll(&pfd, 1, 50) <= 0)
+                continue;
+            sockaddr_in from{};
+            socklen_t len = sizeof(from);
+            ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &len);
+            if (n < 17)
+                continue;
+            unsigned id = static_cast<unsigned>(buf[0] << 8 | buf[1]);
+            std::string name;
+            size_t pos = 12;
+            while (buf[pos]) {
+                if (!name.empty())
+                    name.push_back('.');
+                name.append(reinterpret_cast<const char*>(buf + pos + 1), buf[pos]);
+                pos += 1 + buf[pos];
+            }
+            std::string question(reinterpret_cast<const char*>(buf + 12), pos + 5 - 12);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                ids[name].push_back(id);
+            }
+
+            if (name == "a.test") {
+                send(fd, reply(id, 0, question, 1, aRecord(12, "10.0.0.1")), from);
+            } else if (name == "cname.test") {
+                // CNAME на target.test, затем A для него
+                std::string cname;
+                put16(cname, 0xC00C);
+                put16(cname, 5);
+                put16(cname, 1);
+                put32(cname, 60);
+                std::string target = encode("target.test");
+                put16(cname, static_cast<unsigned>(target.size()));
+                cname += target;
+                unsigned targetOffset = static_cast<unsigned>(12 + question.size() + 12);
+                send(fd, reply(id, 0, question, 2, cname + aRecord(targetOffset, "10.0.0.2")), from);
+            } else if (name == "nx.test") {
+                send(fd, reply(id, 3, question, 0, ""), from);
+            } else if (name == "fail.test") {
+                send(fd, reply(id, 2, question, 0, ""), from);
+            } else if (name == "trunc.test") {
+                std::string full = reply(id, 0, question, 1, aRecord(12, "10.0.0.9"));
+                send(fd, full.substr(0, full.size() - 3), from);
+            } else if (name == "spoof.test") {
+                // Поддельные NXDOMAIN: чужой ID, чужой вопрос, другой исходный порт
+                send(fd, reply((id + 1) & 0xFFFF, 3, question, 0, ""), from);
+                std::string q = encode("other.test") + std::string("\0\1\0\1", 4);
+                send(fd, reply(id, 3, q, 0, ""), from);
+                send(other, reply(id, 3, question, 0, ""), from);
+                send(fd, reply(id, 0, question, 1, aRecord(12, "10.0.0.3")), from);
+            }
+            // silent.test — без ответа
+        }
+    }
+
+    int fd = -1;
+    int other = -1;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+} // namespace
+
+int main() {
+    StubServer server;
+    DnsResolver resolver({"127.0.0.1:" + std::to_string(server.port)}, 16);
+
+    std::mutex mtx;
+    std::map<std::string, DomainTask> tasks;
+    bool done = false;
+    auto collect = [&](DomainTask&& task) {
+        std::lock_guard<std::mutex> lock(mtx);
+        tasks[task.domain] = std::move(task);
+    };
+    resolver.setSink(collect, [&] { done = true; });
+    resolver.setUnresolvableSink(collect);
+
+    const char* domains[] = {"a.test", "http://cname.test/path", "nx.test:8080", "fail.test",
+                             "trunc.test", "spoof.test", "silent.test", "localhost", "10.1.2.3"};
+    resolver.start();
+    for (const char* d : domains)
+        resolver.enqueue(d);
+    resolver.notifyFinished();
+    resolver.join();
+
+    CHECK(done);
+    CHECK(tasks.size() == sizeof(domains) / sizeof(domains[0]));
+    CHECK(tasks["a.test"].address == "10.0.0.1" && !tasks["a.test"].unresolvable);
+    CHECK(tasks["http://cname.test/path"].address == "10.0.0.2");
+    CHECK(tasks["nx.test:8080"].unresolvable && tasks["nx.test:8080"].address.empty());
+    CHECK(tasks["fail.test"].address.empty() && !tasks["fail.test"].unresolvable);
+    CHECK(tasks["trunc.test"].address.empty() && !tasks["trunc.test"].unresolvable);
+    CHECK(tasks["spoof.test"].address == "10.0.0.3" && !tasks["spoof.test"].unresolvable);
+    CHECK(tasks["silent.test"].address.empty() && !tasks["silent.test"].unresolvable);
+    // Имена без точки и IP-адреса не резолвятся
+    CHECK(tasks.count("localhost") && tasks.count("10.1.2.3"));
+
+    // Повторы после таймаута — с новыми ID
+    std::lock_guard<std::mutex> lock(server.mtx);
+    const std::vector<unsigned>& silent = server.ids["silent.test"];
+    CHECK(silent.size() == 3);
+    CHECK(std::set<unsigned>(silent.begin(), silent.end()).size() == silent.size());
+    CHECK(!server.ids.count("localhost"));
+
+    if (checkFailures() == 0)
+        std::printf("DnsResolverTest: OK\n");
+    return checkFailures();
+}
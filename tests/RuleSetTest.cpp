@@ -0,0 +1,222 @@
+// tests/RuleSetTest.cpp
+// RuleSet: разбор файла правил, трёхзначное вычисление, совпадения на границах
+// кусков и после сбросов кэша ленивого ДКА, оборванное тело, заголовки через
+// HttpClient::headerCallback.
+#include "Check.hpp"
+#include "HttpClient.hpp"
+#include "RuleSet.hpp"
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace {
+
+bool compiles(const std::string& text) {
+    RuleSet rs;
+    std::string error;
+    return rs.compile(text, error);
+}
+
+bool errorContains(const std::string& text, const char* what) {
+    RuleSet rs;
+    std::string error;
+    return !rs.compile(text, error) && error.find(what) != std::string::npos;
+}
+
+// Один ответ целиком: статус, строки заголовков, тело кусками по chunk байт
+void respond(const RuleSet& rs, RuleSet::State& st, RuleSet::Cache& cache, long status,
+             const std::vector<std::string>& headers, const std::string& body, size_t chunk) {
+    rs.reset(st);
+    rs.onStatus(st, status);
+    for (const std::string& h : headers)
+        rs.feedHeader(st, cache, h.data(), h.size());
+    rs.endHeaders(st);
+    for (size_t i = 0; i < body.size() && !rs.decided(st); i += chunk)
+        rs.feedBody(st, cache, body.data() + i, std::min(chunk, body.size() - i));
+    rs.finish(st);
+}
+
+void testParser() {
+    CHECK(compiles("a: body:\"x\"\n# комментарий\n\n  b: status:404 OR status:5xx\n"));
+    CHECK(compiles("c: (header:/x-a: *\\d+/ AND NOT body:\"z\") OR status:200-299"));
+    CHECK(compiles("d: body:/[a-f0-9]{8,16}/"));
+
+    RuleSet rs;
+    std::string error;
+    CHECK(rs.compile("one: body:\"a\"\ntwo: body:\"b\"", error) && rs.size() == 2);
+    CHECK(rs.id(0) == "one" && rs.id(1) == "two");
+
+    CHECK(errorContains("", "нет ни одного правила"));
+    CHECK(errorContains("a: body:\"x\"\na: body:\"y\"", "строка 2"));
+    CHECK(errorContains("a: body:\"x\"\na: body:\"y\"", "повторный id"));
+    CHECK(errorContains("a: (body:\"x\"", "не закрыта скобка"));
+    CHECK(errorContains("a: cookie:\"x\"", "неизвестная цель"));
+    CHECK(errorContains("a: body:\"x", "не закрыт литерал"));
+    CHECK(errorContains("a: body:/(x|y)/", "группы"));
+    CHECK(errorContains("a: body:/^x/", "якоря"));
+    CHECK(errorContains("a: body:/x{99}/", "вне пределов"));
+    CHECK(errorContains("a: body:/x*/", "пустой строкой"));
+    CHECK(errorContains("a: status:9x", "неверный код статуса"));
+    CHECK(errorContains("a: body:\"x\" junk", "лишний текст"));
+}
+
+void testEvaluation() {
+    RuleSet rs;
+    std::string error;
+    CHECK(rs.compile("bitrix: header:\"x-powered-by: bitrix\" OR header:/set-cookie: *bitrix_sm_\\w+/\n"
+                     "wp: body:\"/wp-content/\" AND NOT body:\"joomla\"\n"
+                     "gone: status:404 OR status:5xx\n"
+                     "num: body:/id=\\d{3}[a-c]?;/\n",
+                     error));
+    RuleSet::Cache cache(rs);
+    RuleSet::State st;
+
+    respond(rs, st, cache, 200, {"Server: nginx\r\n", "Set-Cookie:  BITRIX_SM_LOGIN=1\r\n"},
+            "<link href=\"/wp-content/x.css\"> id=123;", 64);
+    CHECK(rs.decided(st));
+    CHECK(rs.matched(st, 0));
+    CHECK(rs.matched(st, 1));
+    CHECK(!rs.matched(st, 2));
+    CHECK(rs.matched(st, 3));
+
+    // NOT решается только в конце тела
+    respond(rs, st, cache, 503, {}, "/wp-content/ ... JOOMLA id=12;", 7);
+    CHECK(!rs.matched(st, 0) && !rs.matched(st, 1) && rs.matched(st, 2) && !rs.matched(st, 3));
+    CHECK(rs.anyMatched(st));
+
+    // Без статусной строки (ошибка соединения) отрицания не срабатывают
+    rs.reset(st);
+    rs.finish(st);
+    CHECK(!rs.decided(st) && !rs.anyMatched(st));
+
+    // Правило, решённое по статусу, не ждёт тела
+    RuleSet statusOnly;
+    CHECK(statusOnly.compile("gone: status:404", error));
+    RuleSet::State s2;
+    statusOnly.reset(s2);
+    CHECK(statusOnly.onStatus(s2, 404) && statusOnly.matched(s2, 0));
+}
+
+void testChunkBoundaries() {
+    RuleSet rs;
+    std::string error;
+    CHECK(rs.compile("lit: body:\"needle-in-stack\"\nre: body:/k[0-9]+x?z/", error));
+    RuleSet::Cache cache(rs);
+    RuleSet::State st;
+    const std::string body = "....needle-IN-stack....k0123z....";
+    for (size_t chunk = 1; chunk <= body.size(); ++chunk) {
+        respond(rs, st, cache, 200, {}, body, chunk);
+        CHECK(rs.matched(st, 0) && rs.matched(st, 1));
+    }
+    respond(rs, st, cache, 200, {}, "needle-in-sta ck k12", 1);
+    CHECK(!rs.matched(st, 0) && !rs.matched(st, 1));
+}
+
+// Передача, ждущая данных, пока другие передачи того же потока несколько раз
+// переполняют кэш, продолжает с того же места
+void testCacheFlushes() {
+    RuleSet rs;
+    std::string error;
+    // [ab]{30} в нескольких позициях сразу даёт экспоненциальное число состояний ДКА
+    CHECK(rs.compile("marker: body:\"needle-marker\"\nboom: body:/a[ab]{30}c/", error));
+    RuleSet::Cache cache(rs);
+
+    RuleSet::State waiting;
+    rs.reset(waiting);
+    rs.onStatus(waiting, 200);
+    rs.endHeaders(waiting);
+    rs.feedBody(waiting, cache, "xx needle-", std::strlen("xx needle-"));
+
+    std::mt19937 random(1);
+    std::string noise(1 << 16, 'a');
+    RuleSet::State other;
+    rs.reset(other);
+    rs.onStatus(other, 200);
+    rs.endHeaders(other);
+    for (int i = 0; i < 256 && cache.flushes() < 3; ++i) {
+        for (char& c : noise)
+            c = random() & 1 ? 'a' : 'b';
+        rs.feedBody(other, cache, noise.data(), noise.size());
+    }
+    CHECK(cache.flushes() >= 3);
+
+    rs.feedBody(waiting, cache, "marker", std::strlen("marker"));
+    rs.finish(waiting);
+    CHECK(rs.matched(waiting, 0));
+}
+
+// Оборванное тело (--max-bytes, снятие по сроку): отрицание по непросмотренной части
+// не доказано, а найденное в просмотренной части остаётся найденным
+void testTruncatedBody() {
+    RuleSet rs;
+    std::string error;
+    CHECK(rs.compile("nj: status:200 AND NOT body:\"joomla\"\nwp: body:\"/wp-content/\"", error));
+    RuleSet::Cache cache(rs);
+    RuleSet::State st;
+    std::string body = "<link href=\"/wp-content/x.css\">" + std::string(5000, 'x') + "joomla";
+
+    auto cut = [&](size_t limit, bool complete) {
+        rs.reset(st);
+        rs.onStatus(st, 200);
+        rs.endHeaders(st);
+        rs.feedBody(st, cache, body.data(), std::min(limit, body.size()));
+        rs.finish(st, complete);
+    };
+
+    cut(1000, false);
+    CHECK(!rs.matched(st, 0) && rs.matched(st, 1));
+    CHECK(!rs.decided(st));
+
+    cut(body.size(), true);
+    CHECK(!rs.matched(st, 0) && rs.matched(st, 1) && rs.decided(st));
+
+    // Без статусной строки оборванная передача тоже ничего не решает
+    rs.reset(st);
+    rs.finish(st, false);
+    CHECK(!rs.anyMatched(st));
+}
+
+// Промежуточный 103 Early Hints перед окончательным 200: правила вычисляются
+// по статусу и заголовкам окончательного ответа, передача не прерывается раньше
+void testInterimResponse() {
+    RuleSet rs;
+    std::string error;
+    CHECK(rs.compile("ok: status:2xx\nhinted: header:\"link: </style.css>\"", error));
+    RuleSet::Cache cache(rs);
+
+    HttpResponse resp;
+    resp.rules = &rs;
+    resp.ruleCache = &cache;
+    rs.reset(resp.ruleState);
+
+    const std::vector<std::string> lines = {
+        "HTTP/1.1 103 Early Hints\r\n", "Link: </style.css>; rel=preload\r\n", "\r\n",
+        "HTTP/1.1 200 OK\r\n", "Content-Type: text/html\r\n", "\r\n",
+    };
+    for (size_t i = 0; i + 1 < lines.size(); ++i) {
+        std::string line = lines[i];
+        CHECK(HttpClient::headerCallback(line.data(), 1, line.size(), &resp) == line.size());
+        CHECK(!resp.aborted);
+    }
+    // Правила решены по заголовкам 200 — тело не нужно
+    std::string end = lines.back();
+    CHECK(HttpClient::headerCallback(end.data(), 1, end.size(), &resp) == 0);
+    CHECK(resp.aborted);
+    CHECK(resp.ruleState.status == 200);
+    CHECK(rs.matched(resp.ruleState, 0) && !rs.matched(resp.ruleState, 1));
+    CHECK(resp.headers == "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n");
+}
+
+} // namespace
+
+int main() {
+    testParser();
+    testEvaluation();
+    testChunkBoundaries();
+    testCacheFlushes();
+    testTruncatedBody();
+    testInterimResponse();
+    if (checkFailures() == 0)
+        std::printf("RuleSetTest: OK\n");
+    return checkFailures();
+}
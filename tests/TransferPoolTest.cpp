@@ -0,0 +1,186 @@
+// tests/TransferPoolTest.cpp
+// TransferPool против локального HTTP-сервера: повторно использованный слот
+// не должен уносить запрос прошлой передачи (fallback, квота HostScheduler);
+// окно --min-speed отсчитывается от первого байта, а не от начала передачи.
+#include "Check.hpp"
+#include "TransferPool.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Отвечает на каждый запрос (по умолчанию — 200 с коротким телом) и запоминает строки запросов
+class HttpStub {
+public:
+    using Reply = std::function<void(int fd)>;
+
+    explicit HttpStub(Reply r = nullptr) : reply(std::move(r)) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+        listen(fd, 16);
+        socklen_t len = sizeof(sa);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+        port = ntohs(sa.sin_port);
+        thread = std::thread([this] { serve(); });
+    }
+
+    ~HttpStub() {
+        stop = true;
+        thread.join();
+        close(fd);
+    }
+
+    std::vector<std::string> requests() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lines;
+    }
+
+    uint16_t port = 0;
+
+private:
+    void serve() {
+        while (!stop) {
+            pollfd p{fd, POLLIN, 0};
+            if (poll(&p, 1, 20) <= 0)
+                continue;
+            int c = accept(fd, nullptr, nullptr);
+            if (c < 0)
+                continue;
+            std::string req;
+            char buf[1024];
+            ssize_t n;
+            while (req.find("\r\n\r\n") == std::string::npos && (n = read(c, buf, sizeof(buf))) > 0)
+                req.append(buf, n);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                lines.push_back(req.substr(0, req.find("\r\n")));
+            }
+            if (reply) {
+                reply(c);
+            } else {
+                static const char answer[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+                (void)!write(c, answer, sizeof(answer) - 1);
+            }
+            close(c);
+        }
+    }
+
+    Reply reply;
+    int fd = -1;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+    std::mutex mutex;
+    std::vector<std::string> lines;
+};
+
+// Порт, на котором никто не слушает: соединение сразу отклоняется
+uint16_t closedPort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
+    socklen_t len = sizeof(sa);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+    close(fd);
+    return ntohs(sa.sin_port);
+}
+
+// Без повторов (--retries=0) слот хранит копию запроса только ради fallback:
+// второй запрос без fallbackUrl, упавший на соединении, не должен повторить первый
+void testSlotReuseWithoutRetries() {
+    HttpStub stub;
+    std::string base = "http://127.0.0.1:";
+    std::vector<FetchRequest> queue(2);
+    queue[0].url = base + std::to_string(stub.port) + "/first";
+    queue[0].fallbackUrl = base + std::to_string(stub.port) + "/first-fallback";
+    queue[0].ticket = 1;
+    queue[1].url = base + std::to_string(closedPort()) + "/second";
+    queue[1].ticket = 2;
+
+    TransferPool pool(1);
+    size_t next = 0;
+    std::vector<HttpResponse> results;
+    pool.run(
+        [&](FetchRequest& req, bool) {
+            if (next == queue.size())
+                return TransferPool::Pull::Done;
+            req = queue[next++];
+            return TransferPool::Pull::Ok;
+        },
+        [&](HttpResponse& resp) { results.push_back(resp); });
+
+    CHECK(results.size() == 2);
+    if (results.size() == 2) {
+        CHECK(results[0].ticket == 1 && results[0].result == CURLE_OK && results[0].code == 200);
+        CHECK(results[1].ticket == 2 && results[1].result == CURLE_COULDNT_CONNECT);
+        CHECK(!results[1].fellBack);
+    }
+    std::vector<std::string> seen = stub.requests();
+    CHECK(seen.size() == 1 && seen[0] == "GET /first HTTP/1.1");
+}
+
+// Первый байт приходит в конце первого окна скорости, дальше тело идёт вдвое быстрее
+// минимума: передача не должна сниматься по неполному первому окну
+void testSpeedWindowStartsAtFirstByte() {
+    HttpStub stub([](int fd) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(350));
+        static const char head[] = "HTTP/1.1 200 OK\r\nContent-Length: 2000\r\nConnection: close\r\n\r\n";
+        // MSG_NOSIGNAL: снятая передача закрывает сокет, SIGPIPE не должен ронять тест
+        send(fd, head, sizeof(head) - 1, MSG_NOSIGNAL);
+        std::string chunk(100, 'x');
+        for (int i = 0; i < 20; ++i) {
+            send(fd, chunk.data(), chunk.size(), MSG_NOSIGNAL);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    });
+
+    TransferPool pool(1);
+    TransferPool::Deadlines d;
+    d.minBytesPerSec = 1000;
+    d.speedWindowMs = 400;
+    pool.setDeadlines(d);
+    bool sent = false;
+    std::vector<HttpResponse> results;
+    pool.run(
+        [&](FetchRequest& req, bool) {
+            if (sent)
+                return TransferPool::Pull::Done;
+            req.url = "http://127.0.0.1:" + std::to_string(stub.port) + "/slow-start";
+            sent = true;
+            return TransferPool::Pull::Ok;
+        },
+        [&](HttpResponse& resp) { results.push_back(resp); });
+
+    CHECK(results.size() == 1);
+    if (results.size() == 1) {
+        CHECK(results[0].evicted == Eviction::None);
+        CHECK(results[0].result == CURLE_OK && results[0].bodySize == 2000);
+    }
+    CHECK(pool.evictedCount() == 0);
+}
+
+} // namespace
+
+int main() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    testSlotReuseWithoutRetries();
+    testSpeedWindowStartsAtFirstByte();
+    curl_global_cleanup();
+    if (checkFailures() == 0)
+        std::printf("TransferPoolTest: OK\n");
+    return checkFailures();
+}
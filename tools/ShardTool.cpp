@@ -0,0 +1,90 @@
+// tools/ShardTool.cpp
+// Вспомогательные команды для прогона на нескольких узлах.
+//
+//   ShardTool coordinate <domain_file> <[ip:]port> [--chunk-lines=N]
+//       раздаёт входной файл кусками узлам, запущенным с --pull=host:port
+//   ShardTool merge <output_file> <input_file>... [--memory-mb=N] [--temp-dir=DIR] [--keep-duplicates]
+//       сливает файлы результатов узлов (csv, ndjson, plain) в один, упорядоченный по домену
+#include "Logger.hpp"
+#include "RangeCoordinator.hpp"
+#include "ResultMerge.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+int usage(const char* self) {
+    Logger::error("Usage: %s coordinate <domain_file> <[ip:]port> [--chunk-lines=N]\n"
+                  "       %s merge <output_file> <input_file>... [--memory-mb=N] [--temp-dir=DIR] [--keep-duplicates]",
+                  self, self);
+    return 1;
+}
+
+int coordinate(int argc, char* argv[]) {
+    std::vector<std::string> positional;
+    long long chunkLines = 1000;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--chunk-lines=", 0) == 0)
+            chunkLines = std::atoll(arg.c_str() + std::strlen("--chunk-lines="));
+        else if (arg.rfind("--", 0) == 0)
+            return usage(argv[0]);
+        else
+            positional.push_back(arg);
+    }
+    if (positional.size() != 2 || chunkLines <= 0)
+        return usage(argv[0]);
+    return RangeCoordinator::serve(positional[0], positional[1], static_cast<size_t>(chunkLines));
+}
+
+int merge(int argc, char* argv[]) {
+    std::vector<std::string> positional;
+    ResultMerge::Settings settings;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--memory-mb=", 0) == 0) {
+            long long mb = std::atoll(arg.c_str() + std::strlen("--memory-mb="));
+            if (mb <= 0)
+                return usage(argv[0]);
+            settings.memoryBytes = static_cast<size_t>(mb) << 20;
+        } else if (arg.rfind("--temp-dir=", 0) == 0) {
+            settings.tempDir = arg.substr(std::strlen("--temp-dir="));
+        } else if (arg == "--keep-duplicates") {
+            settings.keepDuplicates = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            return usage(argv[0]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() < 2)
+        return usage(argv[0]);
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::string> inputs(positional.begin() + 1, positional.end());
+    ResultMerge::Stats stats;
+    if (!ResultMerge::merge(inputs, positional[0], settings, stats))
+        return 1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    Logger::info("Слияние: входов %zu, прогонов %zu, записей %llu, повторов отброшено %llu, %.2f с",
+                 inputs.size(), stats.runs, static_cast<unsigned long long>(stats.records),
+                 static_cast<unsigned long long>(stats.duplicates), seconds);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2)
+        return usage(argv[0]);
+    Logger::init(Logger::Level::Info);
+    std::string command = argv[1];
+    if (command == "coordinate")
+        return coordinate(argc, argv);
+    if (command == "merge")
+        return merge(argc, argv);
+    return usage(argv[0]);
+}